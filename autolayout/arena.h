@@ -0,0 +1,181 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace autolayout
+{
+    // One View's memory (see View::setArena): blocks carved from chunks it allocates, recycled by power-of-two size
+    // class. A freed block waits in its class's list for the next allocation of that size, so solver churn and a
+    // reset()'s re-layout reuse the View's own chunks instead of the global heap. Chunks go back all at once, with
+    // the arena. Blocks above the largest class come from the heap directly.
+    class Arena
+    {
+    public:
+        struct Stats
+        {
+            size_t chunks = 0;
+            size_t reserved = 0;        // bytes in chunks
+            size_t used = 0;            // bytes in blocks handed out and not freed, by their class size
+            uint64_t allocations = 0;
+            uint64_t recycled = 0;      // ... served from a free list
+        };
+
+        Arena() = default;
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        ~Arena()
+        {
+            for(auto* chunk : _chunks)
+                ::operator delete(chunk);
+        }
+
+        void* allocate(size_t bytes)
+        {
+            auto const cls = _class(bytes);
+            if(cls == CLASSES)
+                return ::operator new(bytes);
+
+            _stats.allocations++;
+            _stats.used += _size(cls);
+            if(auto* block = _free[cls])
+            {
+                _free[cls] = block->next;
+                _stats.recycled++;
+                return block;
+            }
+
+            if(_end - _top < (ptrdiff_t)_size(cls))
+                _grow(_size(cls));
+            auto* block = _top;
+            _top += _size(cls);
+            return block;
+        }
+
+        void deallocate(void* p, size_t bytes)
+        {
+            auto const cls = _class(bytes);
+            if(cls == CLASSES)
+            {
+                ::operator delete(p);
+                return;
+            }
+
+            _stats.used -= _size(cls);
+            _free[cls] = new(p) Free{ _free[cls] };
+        }
+
+        const Stats& stats() const { return _stats; }
+
+    private:
+        static constexpr size_t MIN_BLOCK = 16;
+        static constexpr size_t CLASSES = 11;               // 16 bytes to 16KB
+        static constexpr size_t FIRST_CHUNK = 4 * 1024;
+        static constexpr size_t MAX_CHUNK = 256 * 1024;
+
+        struct Free { Free* next; };
+
+        std::array<Free*, CLASSES> _free = {};
+        std::vector<void*> _chunks = {};
+        char* _top = nullptr;
+        char* _end = nullptr;
+        Stats _stats = {};
+
+        static size_t _size(size_t cls) { return MIN_BLOCK << cls; }
+
+        static size_t _class(size_t bytes)
+        {
+            auto cls = size_t{0};
+            while(cls < CLASSES && _size(cls) < bytes)
+                cls++;
+            return cls;
+        }
+
+        // the next chunk doubles the last, up to MAX_CHUNK; what the last had left stays unused
+        void _grow(size_t atLeast)
+        {
+            auto size = _chunks.empty() ? FIRST_CHUNK : std::min(MAX_CHUNK, (size_t)(_end - (char*)_chunks.back()) * 2);
+            size = std::max(size, atLeast);
+            _chunks.push_back(::operator new(size));
+            _top = (char*)_chunks.back();
+            _end = _top + size;
+            _stats.chunks++;
+            _stats.reserved += size;
+        }
+    };
+
+    // std allocator over an Arena; without one (the default), the global heap. Containers take their arena
+    // along when moved, copied or swapped.
+    template<typename T>
+    struct ArenaAllocator
+    {
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        Arena* arena = nullptr;
+
+        ArenaAllocator() = default;
+        explicit ArenaAllocator(Arena* arena) : arena(arena) {}
+        template<typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+        T* allocate(size_t n)
+        {
+            return (T*)(arena ? arena->allocate(n * sizeof(T)) : ::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            if(arena)
+                arena->deallocate(p, n * sizeof(T));
+            else
+                ::operator delete(p);
+        }
+
+        template<typename U>
+        bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+        template<typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+    };
+
+    template<typename K, typename V>
+    using ArenaMap = std::map<K, V, std::less<K>, ArenaAllocator<std::pair<const K, V>>>;
+
+    // an empty container allocating from arena
+    template<typename C>
+    C arena_container(Arena* arena) { return C(typename C::allocator_type(arena)); }
+
+    // an object of the arena's (the heap's, without one)
+    template<typename T, typename... Args>
+    T* arena_new(Arena* arena, Args&&... args)
+    {
+        return new(ArenaAllocator<T>(arena).allocate(1)) T(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    void arena_delete(Arena* arena, T* object)
+    {
+        if(!object)
+            return;
+        object->~T();
+        ArenaAllocator<T>(arena).deallocate(object, 1);
+    }
+
+    // unique_ptr deleter for arena_new objects
+    template<typename T>
+    struct ArenaDelete
+    {
+        Arena* arena = nullptr;
+        void operator()(T* object) const { arena_delete(arena, object); }
+    };
+}
@@ -0,0 +1,301 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "variable.h"
+#include "arena.h"
+
+namespace autolayout
+{
+    // Equalities solved by substitution instead of the simplex, for sets that are only chains
+    // (|-[a(100)]-[b]-[c(50)]-|): each constraint is taken once exactly one of its variables is left that
+    // neither an edit nor an earlier constraint determines, and solves for it. A set held this way is
+    // triangular, so once every variable is determined it has one solution, and that meets every constraint
+    // and edit exactly. No error at any strength is the optimum, so priorities can't change it.
+    // Solving is one pass over the terms in that order.
+    class ClosedForm
+    {
+    public:
+        struct Edit
+        {
+            Variable variable;
+            double strength;
+            double value;       // suggested
+        };
+
+        explicit ClosedForm(VariableTable& values, Arena* arena = nullptr)
+            : _values(&values), _index(arena_container<decltype(_index)>(arena)), _cns(arena_container<decltype(_cns)>(arena)) {}
+
+        // false, with nothing changed: an inequality, or its variables are determined already (it would be
+        // redundant or conflict, and strengths decide), or it leaves another constraint so
+        bool add(const Constraint& constraint)
+        {
+            if(constraint.op() != OP_EQ)
+                return false;
+
+            auto const& expr = constraint.expression();
+            auto eq = Eq{ constraint, expr.constant() };
+            auto unknowns = 0u;
+            auto fresh = std::vector<std::pair<size_t, Variable>>{};   // (term, variable) not seen yet
+            for(auto const& term : expr.terms())
+            {
+                if(term.coefficient() == 0.0)
+                    continue;
+
+                auto it = _index.find(term.variable());
+                if(it == _index.end())
+                    fresh.emplace_back(eq.terms.size(), term.variable());
+                unknowns += it == _index.end() || _vars[it->second].by == NONE ? 1 : 0;
+                eq.terms.emplace_back(it != _index.end() ? it->second : NONE, term.coefficient());
+            }
+            if(unknowns == 0)
+                return false;
+
+            auto const firstVar = (uint32_t)_vars.size();
+            auto const id = (uint32_t)_eqs.size();
+            for(auto const& [term, var] : fresh)
+            {
+                eq.terms[term].first = (uint32_t)_vars.size();
+                _index.emplace(var, (uint32_t)_vars.size());
+                _vars.push_back(Var{ var });
+            }
+            eq.unknowns = unknowns;
+            _eqs.push_back(std::move(eq));
+
+            if(unknowns > 1)
+            {
+                for(auto const& [var, coeff] : _eqs[id].terms)
+                {
+                    if(_vars[var].by == NONE)
+                        _vars[var].waiting.push_back(id);
+                }
+            }
+            else if(!_propagate(_unknownOf(id), id))
+            {
+                for(auto v=firstVar; v<_vars.size(); v++)
+                    _index.erase(_vars[v].variable);
+                _vars.resize(firstVar);
+                _eqs.pop_back();
+                return false;
+            }
+
+            _cns.emplace(constraint, id);
+            _changed = true;
+            return true;
+        }
+
+        bool has(const Constraint& constraint) const { return _cns.find(constraint) != _cns.end(); }
+
+        // false, with nothing changed: a constraint determines the variable already, or it leaves one so
+        bool addEdit(const Variable& variable, double strength)
+        {
+            auto [it, added] = _index.emplace(variable, (uint32_t)_vars.size());
+            if(added)
+                _vars.push_back(Var{ variable });
+            else if(_vars[it->second].by != NONE)
+                return false;
+
+            if(!_propagate(it->second, EDIT))
+            {
+                if(added)
+                {
+                    _index.erase(it);
+                    _vars.pop_back();
+                }
+                return false;
+            }
+
+            auto& var = _vars[it->second];
+            var.strength = strength;
+            var.value = 0.0;
+            _edits.push_back(it->second);
+            _changed = true;
+            return true;
+        }
+
+        bool hasEdit(const Variable& variable) const
+        {
+            auto it = _index.find(variable);
+            return it != _index.end() && _vars[it->second].by == EDIT;
+        }
+
+        // suggested, for an edit variable
+        double editValue(const Variable& variable) const { return _vars[_index.at(variable)].value; }
+
+        void suggest(const Variable& variable, double value)
+        {
+            _vars[_index.at(variable)].value = value;
+            _changed = true;
+        }
+
+        // every variable determined: solve() gives the optimum
+        bool complete() const { return _known == _vars.size(); }
+
+        // writes back the variables whose value changed (all of them after invalidate()); requires complete()
+        void solve()
+        {
+            for(auto id : _order)
+            {
+                auto const& eq = _eqs[id];
+                auto sum = eq.constant;
+                auto subject = 0.0;
+                for(auto const& [var, coeff] : eq.terms)
+                {
+                    if(var == eq.subject)
+                        subject = coeff;
+                    else
+                        sum += coeff * _vars[var].value;
+                }
+                _vars[eq.subject].value = -sum / subject;
+            }
+
+            for(auto& var : _vars)
+            {
+                if(_force || _values->value(var.variable) != var.value)
+                    _values->setValue(var.variable, var.value);
+            }
+            _changed = _force = false;
+        }
+
+        bool dirty() const { return _changed; }
+
+        void invalidate() { _changed = _force = true; }
+
+        size_t size() const { return _eqs.size(); }
+        size_t editCount() const { return _edits.size(); }
+
+        // in the order they went in
+        std::vector<Constraint> constraints() const
+        {
+            auto out = std::vector<Constraint>{};
+            out.reserve(_eqs.size());
+            for(auto const& eq : _eqs)
+                out.push_back(eq.constraint);
+            return out;
+        }
+
+        std::vector<Edit> edits() const
+        {
+            auto out = std::vector<Edit>{};
+            out.reserve(_edits.size());
+            for(auto id : _edits)
+                out.push_back(Edit{ _vars[id].variable, _vars[id].strength, _vars[id].value });
+            return out;
+        }
+
+        // vectors by capacity, map nodes by an estimate
+        size_t memoryBytes() const
+        {
+            auto const node = 4 * sizeof(void*);
+            auto bytes = sizeof(ClosedForm) + _vars.capacity() * sizeof(Var) + _eqs.capacity() * sizeof(Eq)
+                    + (_edits.capacity() + _order.capacity()) * sizeof(uint32_t)
+                    + _index.size() * (node + sizeof(*_index.begin())) + _cns.size() * (node + sizeof(*_cns.begin()));
+            for(auto const& var : _vars)
+                bytes += var.waiting.capacity() * sizeof(uint32_t);
+            for(auto const& eq : _eqs)
+                bytes += eq.terms.capacity() * sizeof(eq.terms[0]);
+            return bytes;
+        }
+
+    private:
+        static constexpr uint32_t NONE = UINT32_MAX;
+        static constexpr uint32_t EDIT = UINT32_MAX - 1;
+
+        struct Var
+        {
+            Variable variable;
+            uint32_t by = NONE;                 // the constraint solved for it, EDIT, or NONE while undetermined
+            std::vector<uint32_t> waiting = {}; // constraints with more than one unknown that it is one of
+            double value = 0.0;                 // suggested, for an edit
+            double strength = 0.0;              // for an edit
+        };
+
+        struct Eq
+        {
+            Constraint constraint;
+            double constant;
+            std::vector<std::pair<uint32_t, double>> terms = {};    // (variable, coefficient)
+            uint32_t unknowns = 0;
+            uint32_t subject = NONE;            // the variable it solves for, once taken
+        };
+
+        VariableTable* _values;
+        std::vector<Var> _vars = {};
+        ArenaMap<Variable, uint32_t> _index;
+        std::vector<Eq> _eqs = {};
+        ArenaMap<Constraint, uint32_t> _cns;
+        std::vector<uint32_t> _edits = {};      // variables, in the order they became edits
+        std::vector<uint32_t> _order = {};      // constraints in the order they were taken: solve() follows it
+        size_t _known = 0;
+        bool _changed = false;
+        bool _force = false;
+
+        uint32_t _unknownOf(uint32_t eq) const
+        {
+            for(auto const& [var, coeff] : _eqs[eq].terms)
+            {
+                if(_vars[var].by == NONE)
+                    return var;
+            }
+            return NONE;
+        }
+
+        // determines var by `by` (a constraint or EDIT), then takes every constraint left with one unknown, and
+        // so on. When that would leave one with none, or two solving for the same variable, undoes it all.
+        bool _propagate(uint32_t var, uint32_t by)
+        {
+            auto const order = _order.size();
+            auto made = std::vector<uint32_t>{}, taken = std::vector<uint32_t>{}, counted = std::vector<uint32_t>{};
+            auto undo = [&]
+            {
+                for(auto v : made)
+                    _vars[v].by = NONE;
+                for(auto e : taken)
+                    _eqs[e].subject = NONE;
+                for(auto e : counted)
+                    _eqs[e].unknowns++;
+                _known -= made.size();
+                _order.resize(order);
+                return false;
+            };
+
+            if(by != EDIT)
+            {
+                _eqs[by].subject = var;
+                taken.push_back(by);
+            }
+
+            auto work = std::vector<std::pair<uint32_t, uint32_t>>{ { var, by } };
+            while(!work.empty())
+            {
+                auto const [v, e] = work.back();
+                work.pop_back();
+                if(_vars[v].by != NONE)
+                    return undo();
+
+                _vars[v].by = e;
+                made.push_back(v);
+                _known++;
+                if(e != EDIT)
+                    _order.push_back(e);
+
+                for(auto w : _vars[v].waiting)
+                {
+                    auto& eq = _eqs[w];
+                    if(eq.subject != NONE)
+                        continue;
+                    counted.push_back(w);
+                    if(--eq.unknowns == 0)
+                        return undo();
+                    if(eq.unknowns == 1)
+                    {
+                        eq.subject = _unknownOf(w);
+                        taken.push_back(w);
+                        work.emplace_back(eq.subject, w);
+                    }
+                }
+            }
+            return true;
+        }
+    };
+}
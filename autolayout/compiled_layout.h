@@ -0,0 +1,95 @@
+#pragma once
+#include <boost/optional/optional.hpp>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "./kiwi_fwd.h"
+#include "constraint_def.h"
+
+namespace autolayout
+{
+    // A constraint list with every view name resolved to a slot index, built once and
+    // instantiated into any number of Views (see View::instantiate). Immutable once compiled.
+    class CompiledLayout
+    {
+    public:
+        static constexpr uint32_t SLOT_SUPER = 0;
+        static constexpr uint32_t SLOT_SPACING = UINT32_MAX; // view2 == "-"
+
+        struct Slot
+        {
+            std::string name;
+            uint32_t attrs;     // bit per Attribute referenced, so derived ones are created up front
+        };
+
+        struct Item
+        {
+            uint32_t view1;
+            Attribute attr1;
+            uint32_t view2;
+            Attribute attr2;
+            Relation relation;
+            double multiplier;
+            boost::optional<double> constant;   // none: add the spacing below
+            SpacingType spacing;
+            double strength;
+        };
+
+        static std::shared_ptr<CompiledLayout> compile(const std::vector<ConstraintDef>& defs)
+        {
+            return std::make_shared<CompiledLayout>(defs);
+        }
+
+        explicit CompiledLayout(const std::vector<ConstraintDef>& defs)
+        {
+            std::unordered_map<std::string, uint32_t> indices;
+            indices.reserve(16);
+            _slots.push_back(Slot{ {}, 0 });
+            _items.reserve(defs.size());
+
+            auto slotOf = [&](const std::string& name) -> uint32_t
+            {
+                if(is_super(name))
+                    return SLOT_SUPER;
+
+                auto [it, inserted] = indices.emplace(name, (uint32_t)_slots.size());
+                if(inserted)
+                    _slots.push_back(Slot{ name, 0 });
+                return it->second;
+            };
+
+            for(auto const& def : defs)
+            {
+                auto item = Item{};
+                item.view1 = slotOf(def.view1);
+                item.attr1 = def.attr1;
+                item.view2 = def.view2 == "-" ? SLOT_SPACING : slotOf(def.view2);
+                item.attr2 = def.attr2;
+                item.relation = def.relation;
+                item.multiplier = def.multiplier.value_or(1);
+                item.constant = def.constant;
+                item.spacing = (def.view2 == "-" || !def.constant) ? spacing_type(def) : SPACE_HORIZ;
+                item.strength = kiwi::strength::create(0, def.priority.value_or(500), 1000);
+
+                _slots[item.view1].attrs |= 1u << item.attr1;
+                if(item.view2 != SLOT_SPACING)
+                    _slots[item.view2].attrs |= 1u << item.attr2;
+
+                _items.push_back(item);
+            }
+        }
+
+        const std::vector<Slot>& slots() const { return _slots; }
+        const std::vector<Item>& items() const { return _items; }
+
+        size_t slotCount() const { return _slots.size(); }
+        size_t size() const { return _items.size(); }
+
+    private:
+        std::vector<Slot> _slots;
+        std::vector<Item> _items;
+    };
+}
@@ -35,7 +35,7 @@ namespace autolayout
             case ATTR_HEIGHT: return "height";
             case ATTR_CENTERX: return "centerX";
             case ATTR_CENTERY: return "centerY";
-            default: throw "invalid attr value;";
+            default: return "invalid";
         }
     }
 
@@ -61,6 +61,8 @@ namespace autolayout
         }
     }
 
+    enum SpacingType { SPACE_TOP, SPACE_RIGHT, SPACE_BOTTOM, SPACE_LEFT, SPACE_HORIZ, SPACE_VERT, SPACE__COUNT };
+
     //todo: all var
     struct ConstraintDef
     {
@@ -72,6 +74,7 @@ namespace autolayout
 		boost::optional<double> multiplier {};
 		boost::optional<double> constant {};
 		boost::optional<unsigned> priority {};
+        std::string container {};   // the cascaded view whose children this lays out ([g:[a]] gives "g"); empty at the top level
 
         ConstraintDef(
                 std::string view1,
@@ -114,6 +117,45 @@ namespace autolayout
 
     };
 
+    static bool is_super(const std::string& view) { return view.empty() || view == "^"; }
+
+    //which spacing a def falls back to: for view2 "-" and for a missing constant; SPACE__COUNT for a bad "-".attr2
+    static SpacingType spacing_type(const ConstraintDef& con)
+    {
+        if(con.view2 == "-")
+        {
+            switch (con.attr2)
+            {
+                case ATTR_LEFT: return SPACE_LEFT;
+                case ATTR_RIGHT: return SPACE_RIGHT;
+                case ATTR_WIDTH: return SPACE_HORIZ;
+                case ATTR_HEIGHT: return SPACE_VERT;
+                case ATTR_TOP: return SPACE_TOP;
+                case ATTR_BOTTOM: return SPACE_BOTTOM;
+                default: return SPACE__COUNT;
+            }
+        }
+
+        if(is_super(con.view1) && (con.attr1 == ATTR_LEFT))
+            return SPACE_LEFT;
+        if(is_super(con.view1) && (con.attr1 == ATTR_TOP))
+            return SPACE_TOP;
+        if(is_super(con.view2) && (con.attr2 == ATTR_RIGHT))
+            return SPACE_RIGHT;
+        if(is_super(con.view2) && (con.attr2 == ATTR_BOTTOM))
+            return SPACE_BOTTOM;
+
+        switch(con.attr1)
+        {
+            case ATTR_LEFT:
+            case ATTR_RIGHT:
+            case ATTR_CENTERY:
+                return SPACE_HORIZ;
+            default:
+                return SPACE_VERT;
+        }
+    }
+
 #ifndef EMSCRIPTEN
     std::ostream& operator<<(std::ostream& os, const ConstraintDef& def)
     {
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace autolayout
+{
+    enum TrackSizing
+    {
+        TRACK_FIXED,    // value points
+        TRACK_FR,       // value shares of what the fixed and auto tracks leave
+        TRACK_AUTO      // the largest intrinsic size among the track's single-track cells
+    };
+
+    struct Track
+    {
+        TrackSizing sizing = TRACK_FR;
+        double value = 1;
+    };
+
+    // A grid laid out by the View's own track sizing instead of the solver (G:g(100,1fr)(auto)[a,b][c,.]).
+    // name is a subview placed by ordinary constraints; the cells go inside its frame, tracks spaced by the
+    // horizontal/vertical spacing. A name repeated over a rectangle spans it; "" leaves a slot empty.
+    struct GridDef
+    {
+        std::string name {};
+        std::vector<Track> columns {};      // missing ones are 1fr
+        std::vector<Track> rows {};
+        std::vector<std::vector<std::string>> cells {};     // by row
+    };
+}
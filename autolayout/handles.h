@@ -0,0 +1,139 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace autolayout
+{
+    // Owns the objects the bindings hand out as opaque handles (parse results, collected ViewConstraints) until
+    // release(), so a long-running page doesn't leak them. A handle is a serial number, never reused (a stale one
+    // can't reach the object that took its place), checked against the type it was added as before use. Arenas scope handles: endArena() releases everything added since the
+    // matching beginArena() that is still live.
+    class HandleRegistry
+    {
+    public:
+        struct Stats
+        {
+            size_t live = 0;
+            size_t bytes = 0;           // the objects and their vectors' storage, as of when they were added
+            uint64_t added = 0;
+            uint64_t released = 0;
+        };
+
+        template<typename T>
+        size_t add(std::unique_ptr<T> object)
+        {
+            auto const handle = ++_last;
+            auto const bytes = _bytes(*object);
+            _entries[handle] = Entry{ _tag<T>(), std::shared_ptr<void>(std::move(object)), bytes, _arenas.empty() ? 0 : _arenas.back() };
+            _stats.live++;
+            _stats.bytes += bytes;
+            _stats.added++;
+            return handle;
+        }
+
+        // the object behind handle, or null if it isn't live or isn't a T
+        template<typename T>
+        T* get(size_t handle) const
+        {
+            auto it = _entries.find(handle);
+            return it != _entries.end() && it->second.tag == _tag<T>() ? (T*)it->second.object.get() : nullptr;
+        }
+
+        // element index of the std::vector<T> behind handle (a parse result, say), or null if it isn't one or
+        // index is past its end
+        template<typename T>
+        T* element(size_t handle, size_t index) const
+        {
+            auto* vec = get<std::vector<T>>(handle);
+            return vec && index < vec->size() ? &(*vec)[index] : nullptr;
+        }
+
+        // false for a handle that isn't live
+        bool release(size_t handle)
+        {
+            auto it = _entries.find(handle);
+            if(it == _entries.end())
+                return false;
+            _erase(it);
+            return true;
+        }
+
+        // Arenas nest; returns the new one's depth
+        size_t beginArena()
+        {
+            _arenas.push_back(++_lastArena);
+            return _arenas.size();
+        }
+
+        // releases the innermost arena's live handles; returns how many
+        size_t endArena()
+        {
+            if(_arenas.empty())
+                return 0;
+
+            auto const arena = _arenas.back();
+            _arenas.pop_back();
+            auto released = size_t{0};
+            for(auto it = _entries.begin(); it != _entries.end();)
+            {
+                if(it->second.arena == arena)
+                {
+                    it = _erase(it);
+                    released++;
+                }
+                else
+                    ++it;
+            }
+            return released;
+        }
+
+        const Stats& stats() const { return _stats; }
+
+    private:
+        struct Entry
+        {
+            const void* tag;
+            std::shared_ptr<void> object;   // deletes it as the type it was added as
+            size_t bytes;
+            uint64_t arena;                 // 0: none
+        };
+
+        std::unordered_map<size_t, Entry> _entries = {};
+        std::vector<uint64_t> _arenas = {};     // open ones, innermost last
+        uint64_t _lastArena = 0;
+        size_t _last = 0;                       // handle; 0 is none
+        Stats _stats = {};
+
+        // a type's identity without RTTI (the wasm build has none)
+        template<typename T>
+        static const void* _tag()
+        {
+            static const char tag = 0;
+            return &tag;
+        }
+
+        template<typename T>
+        static size_t _bytes(const T&) { return sizeof(T); }
+
+        template<typename T>
+        static size_t _bytes(const std::vector<T>& v) { return sizeof(v) + v.capacity() * sizeof(T); }
+
+        std::unordered_map<size_t, Entry>::iterator _erase(std::unordered_map<size_t, Entry>::iterator it)
+        {
+            _stats.live--;
+            _stats.bytes -= it->second.bytes;
+            _stats.released++;
+            return _entries.erase(it);
+        }
+    };
+
+    // the one the bindings share
+    inline HandleRegistry& handles()
+    {
+        static HandleRegistry registry;
+        return registry;
+    }
+}
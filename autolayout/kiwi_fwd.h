@@ -3,6 +3,9 @@
 //replace auto_ptr used by kiwi
 #define auto_ptr unique_ptr
 
-#include <kiwi.h>
+// kiwi's strengths and exception types only: the solver and the variables are ours (solver.h, variable.h), and
+// kiwi's solver throws, which a -fno-exceptions build can't compile
+#include <strength.h>
+#include <errors.h>
 
 #undef auto_ptr
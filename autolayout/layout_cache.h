@@ -0,0 +1,118 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace autolayout
+{
+    // Solved variable values keyed by the inputs that produced them (see View::enableCache).
+    // Least recently used entries go first once the stored bytes exceed the cap.
+    class LayoutCache
+    {
+    public:
+        struct Stats
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+            size_t entries = 0;
+            size_t bytes = 0;
+        };
+
+        explicit LayoutCache(size_t maxBytes = 0) : _maxBytes(maxBytes) {}
+
+        size_t maxBytes() const { return _maxBytes; }
+
+        void setMaxBytes(size_t maxBytes)
+        {
+            _maxBytes = maxBytes;
+            _evict();
+        }
+
+        // the values stored for key, or null; a hit makes the entry most recently used
+        const std::vector<double>* find(const std::vector<double>& key)
+        {
+            auto it = _index.find(_hash(key));
+            if(it == _index.end() || it->second->key != key)
+            {
+                _stats.misses++;
+                return nullptr;
+            }
+
+            _stats.hits++;
+            _entries.splice(_entries.begin(), _entries, it->second);
+            return &it->second->values;
+        }
+
+        void store(std::vector<double> key, std::vector<double> values)
+        {
+            auto const hash = _hash(key);
+            auto it = _index.find(hash);
+            if(it != _index.end())
+                _erase(it);
+
+            _entries.push_front(Entry{ hash, std::move(key), std::move(values) });
+            _index[hash] = _entries.begin();
+            _stats.bytes += _size(_entries.front());
+            _stats.entries++;
+            _evict();
+        }
+
+        void clear()
+        {
+            _entries.clear();
+            _index.clear();
+            _stats.entries = _stats.bytes = 0;
+        }
+
+        const Stats& stats() const { return _stats; }
+
+    private:
+        struct Entry
+        {
+            uint64_t hash;
+            std::vector<double> key;
+            std::vector<double> values;
+        };
+
+        size_t _maxBytes;
+        std::list<Entry> _entries = {};     // most recently used first
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> _index = {};
+        Stats _stats = {};
+
+        static size_t _size(const Entry& e) { return sizeof(Entry) + (e.key.size() + e.values.size()) * sizeof(double); }
+
+        // FNV-1a over the bytes of the key
+        static uint64_t _hash(const std::vector<double>& key)
+        {
+            auto h = uint64_t{14695981039346656037ull};
+            for(auto v : key)
+            {
+                uint64_t bits;
+                std::memcpy(&bits, &v, sizeof bits);
+                for(int i=0; i<8; i++, bits >>= 8)
+                    h = (h ^ (bits & 0xff)) * 1099511628211ull;
+            }
+            return h;
+        }
+
+        void _erase(std::unordered_map<uint64_t, std::list<Entry>::iterator>::iterator it)
+        {
+            _stats.bytes -= _size(*it->second);
+            _stats.entries--;
+            _entries.erase(it->second);
+            _index.erase(it);
+        }
+
+        void _evict()
+        {
+            while(!_entries.empty() && _stats.bytes > _maxBytes)
+            {
+                _erase(_index.find(_entries.back().hash));
+                _stats.evictions++;
+            }
+        }
+    };
+}
@@ -0,0 +1,1555 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <set>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "variable.h"
+#include "arena.h"
+#include "closed_form.h"
+#include "status.h"
+
+namespace autolayout
+{
+    // The cassowary simplex of kiwi's SolverImpl, over Variable/Expression/Constraint (variable.h); values go to
+    // the VariableTable it is given.
+    // Unlike kiwi::Solver it owns its tableau, so callers can defer the objective
+    // optimization across many edits (see beginBatch/commit).
+    // Until a constraint or an operation needs the tableau, the constraints are solved in closed form instead.
+    // Rows, their cells and the maps come from the arena it is given, if any (see View::setArena).
+    class Solver
+    {
+    public:
+        struct Stats
+        {
+            uint64_t suggestions = 0;           // suggestValue calls that changed a value
+            uint64_t skippedSuggestions = 0;    // ... and those equal to the current one
+            uint64_t updates = 0;               // updateVariables calls that had values to write back
+            uint64_t skippedUpdates = 0;        // ... and those with nothing changed
+        };
+
+        struct Symbol
+        {
+            enum Type : uint8_t { SYM_INVALID, SYM_EXTERNAL, SYM_SLACK, SYM_ERROR, SYM_DUMMY };
+
+            uint32_t id = 0;
+            Type type = SYM_INVALID;
+
+            bool valid() const { return type != SYM_INVALID; }
+            bool restricted() const { return type == SYM_SLACK || type == SYM_ERROR; }
+        };
+
+        class Row
+        {
+        public:
+            struct Cell
+            {
+                Symbol sym;
+                double coeff;
+            };
+
+            using Cells = std::vector<Cell, ArenaAllocator<Cell>>;
+
+            Row() = default;
+            explicit Row(double constant, Arena* arena = nullptr) : _cells(ArenaAllocator<Cell>(arena)), _constant(constant) {}
+
+            const Cells& cells() const { return _cells; }
+            double constant() const { return _constant; }
+            double add(double value) { return _constant += value; }
+
+            double coefficientFor(Symbol sym) const
+            {
+                auto it = _find(sym);
+                return it != _cells.end() && it->sym.id == sym.id ? it->coeff : 0.0;
+            }
+
+            void insert(Symbol sym, double coeff = 1.0)
+            {
+                auto it = _find(sym);
+                if(it != _cells.end() && it->sym.id == sym.id)
+                {
+                    if(nearZero(it->coeff += coeff))
+                        _cells.erase(it);
+                }
+                else if(!nearZero(coeff))
+                    _cells.insert(it, Cell{ sym, coeff });
+            }
+
+            // this += other * coeff; merges the sorted cells in place from the back
+            void insert(const Row& other, double coeff = 1.0)
+            {
+                _constant += other._constant * coeff;
+
+                auto const n = _cells.size();
+                auto extra = size_t{0};
+                for(size_t i=0, j=0; j<other._cells.size(); j++)
+                {
+                    while(i < n && _cells[i].sym.id < other._cells[j].sym.id)
+                        i++;
+                    if(i == n || _cells[i].sym.id != other._cells[j].sym.id)
+                        extra++;
+                }
+
+                _cells.resize(n + extra);
+                auto i = (ptrdiff_t)n - 1, j = (ptrdiff_t)other._cells.size() - 1, k = (ptrdiff_t)(n + extra) - 1;
+                while(j >= 0)
+                {
+                    auto const& src = other._cells[j];
+                    if(i >= 0 && _cells[i].sym.id > src.sym.id)
+                        _cells[k--] = _cells[i--];
+                    else if(i >= 0 && _cells[i].sym.id == src.sym.id)
+                    {
+                        _cells[k] = _cells[i--];
+                        _cells[k--].coeff += src.coeff * coeff;
+                        j--;
+                    }
+                    else
+                    {
+                        _cells[k--] = Cell{ src.sym, src.coeff * coeff };
+                        j--;
+                    }
+                }
+
+                _cells.erase(std::remove_if(_cells.begin(), _cells.end(), [](const Cell& c){ return nearZero(c.coeff); }), _cells.end());
+            }
+
+            void remove(Symbol sym)
+            {
+                auto it = _find(sym);
+                if(it != _cells.end() && it->sym.id == sym.id)
+                    _cells.erase(it);
+            }
+
+            void reverseSign()
+            {
+                _constant = -_constant;
+                for(auto& c : _cells)
+                    c.coeff = -c.coeff;
+            }
+
+            // solve the row for sym, which must be in the row: 0 = ... + a*sym  =>  sym = ...
+            void solveFor(Symbol sym)
+            {
+                auto it = _find(sym);
+                auto const coeff = -1.0 / it->coeff;
+                _cells.erase(it);
+
+                _constant *= coeff;
+                for(auto& c : _cells)
+                    c.coeff *= coeff;
+            }
+
+            // lhs = row  =>  rhs = ...
+            void solveFor(Symbol lhs, Symbol rhs)
+            {
+                insert(lhs, -1.0);
+                solveFor(rhs);
+            }
+
+            bool substitute(Symbol sym, const Row& row)
+            {
+                auto it = _find(sym);
+                if(it == _cells.end() || it->sym.id != sym.id)
+                    return false;
+
+                auto const coeff = it->coeff;
+                _cells.erase(it);
+                insert(row, coeff);
+                return true;
+            }
+
+            // symbol ids through ids (old id -> new, order-preserving), cells at exact capacity
+            void renumber(const std::vector<uint32_t>& ids)
+            {
+                for(auto& c : _cells)
+                    c.sym.id = ids[c.sym.id];
+                _cells.shrink_to_fit();
+            }
+
+            size_t memoryBytes() const { return sizeof(Row) + _cells.capacity() * sizeof(Cell); }
+
+            static bool nearZero(double value)
+            {
+                const double eps = 1.0e-8;
+                return value < 0.0 ? -value < eps : value < eps;
+            }
+
+        private:
+            Cells _cells;
+            double _constant = 0.0;
+
+            Cells::iterator _find(Symbol sym)
+            {
+                return std::lower_bound(_cells.begin(), _cells.end(), sym.id, [](const Cell& c, uint32_t id){ return c.sym.id < id; });
+            }
+
+            Cells::const_iterator _find(Symbol sym) const
+            {
+                return std::lower_bound(_cells.begin(), _cells.end(), sym.id, [](const Cell& c, uint32_t id){ return c.sym.id < id; });
+            }
+        };
+
+        // Values of some variables, and the constants of the restricted rows, as affine functions of some edit
+        // variables' suggested values, for the basis the solver had when it was made. While no restricted row
+        // goes negative that basis stays optimal, so evaluating is a few multiply-adds instead of a solve.
+        class Parametric
+        {
+        public:
+            // false: the values leave the basis infeasible, and outputs are not meaningful; suggest them instead
+            bool evaluate(const double* values, double* outputs) const
+            {
+                _scratch = _rowBase;
+                std::copy(_outBase.begin(), _outBase.end(), outputs);
+
+                for(size_t e=0; e<_base.size(); e++)
+                {
+                    auto const delta = values[e] - _base[e];
+                    if(delta == 0.0)
+                        continue;
+
+                    for(auto const& [row, coeff] : _rowTerms[e])
+                        _scratch[row] += delta * coeff;
+                    for(auto const& [out, coeff] : _outTerms[e])
+                        outputs[out] += delta * coeff;
+                }
+
+                for(auto c : _scratch)
+                {
+                    if(c < 0.0 && !Row::nearZero(c))
+                        return false;
+                }
+                return true;
+            }
+
+        private:
+            std::vector<double> _base;                                      // by edit: suggested value when made
+            std::vector<double> _outBase;                                   // by output
+            std::vector<double> _rowBase;                                   // by affected restricted row
+            std::vector<std::vector<std::pair<uint32_t, double>>> _outTerms;   // by edit: (output, coefficient)
+            std::vector<std::vector<std::pair<uint32_t, double>>> _rowTerms;   // by edit: (row, coefficient)
+            mutable std::vector<double> _scratch;
+            friend class Solver;
+        };
+
+    private:
+        struct Tag
+        {
+            Symbol marker;
+            Symbol other;
+        };
+
+        struct EditInfo
+        {
+            Tag tag;
+            Constraint constraint;
+            double constant;
+        };
+
+        // what addConstraints knows about the rest of the set
+        struct Bulk
+        {
+            uint32_t firstId;                   // symbols from here on were created by this load
+            std::vector<uint32_t> uses = {};    // by symbol id: references by constraints not yet added
+            std::vector<bool> seen = {};        // by symbol id: referenced by a constraint already added
+
+            // occurs in no row yet
+            bool fresh(Symbol sym) const { return sym.id >= firstId && sym.id < seen.size() && !seen[sym.id]; }
+        };
+
+        using RowPtr = std::unique_ptr<Row, ArenaDelete<Row>>;
+
+        VariableTable* _values;
+        Arena* _arena;
+        ArenaMap<Constraint, Tag> _cns;
+        ArenaMap<Variable, Symbol> _vars;
+        ArenaMap<Variable, EditInfo> _edits;
+        std::vector<RowPtr> _rows = {};                 // by symbol id; null unless the symbol is basic
+        std::vector<Symbol::Type> _types = {};          // by symbol id
+        std::vector<Variable> _variables = {};          // by symbol id, for external symbols
+        std::vector<bool> _dirty = {};                  // by symbol id: value changed since the last updateVariables
+        std::vector<uint32_t> _dirtyList = {};
+        std::vector<Symbol> _infeasibleRows = {};
+        Row _objective = {};
+        RowPtr _artificial = {};
+        bool _batch = false;
+        bool _optimizePending = false;
+        int _suggestDepth = 0;
+        bool _dualPending = false;
+        std::vector<std::pair<Symbol, double>> _markerDeltas = {};  // suggestions on non-basic edit markers, until flush
+        Stats _stats = {};
+        uint64_t _generation = 0;       // bumped by every constraint added or removed
+        std::vector<Constraint>* _collect = nullptr;
+        std::unique_ptr<ClosedForm> _closed = {};   // while every constraint fits one; null once the tableau has them
+        bool _closedForm = true;                    // false: straight to the tableau from reset() on
+
+    public:
+        explicit Solver(VariableTable& values, bool closedForm = true, Arena* arena = nullptr)
+            : _values(&values), _arena(arena), _cns(arena_container<decltype(_cns)>(arena)), _vars(arena_container<decltype(_vars)>(arena)),
+              _edits(arena_container<decltype(_edits)>(arena)), _closedForm(closedForm)
+        {
+            reset();
+        }
+
+        Status addConstraint(const Constraint& constraint)
+        {
+            if(_collect)
+            {
+                _collect->push_back(constraint);
+                return STATUS_OK;
+            }
+
+            if(_closed)
+            {
+                if(_closed->has(constraint))
+                    return STATUS_DUPLICATE_CONSTRAINT;
+                if(_closed->add(constraint))
+                {
+                    _generation++;
+                    return STATUS_OK;
+                }
+                _materialize();
+            }
+
+            _flushSuggestions();
+            if(auto const status = _addConstraint(constraint))
+                return status;
+            _optimizeObjective();
+            return STATUS_OK;
+        }
+
+        // Bulk load: adds a whole set with a single optimization.
+        // Knowing the whole set, each row is solved for a variable no earlier row mentioned when it has one, which
+        // substitutes into nothing, else for the one with the fewest references still to come (its row is copied into
+        // each of them). Chains laid out in order then build in linear time instead of filling in quadratically.
+        // On failure the constraints before the failing one stay added.
+        Status addConstraints(const std::vector<Constraint>& constraints)
+        {
+            if(_closed)
+            {
+                auto taken = size_t{0};
+                if(auto const status = _addClosed(constraints, taken))
+                    return status;
+                if(taken == constraints.size())
+                    return STATUS_OK;
+
+                _materialize();
+                if(taken)
+                    return addConstraints(std::vector<Constraint>(constraints.begin() + taken, constraints.end()));
+            }
+
+            auto bulk = Bulk{ (uint32_t)_types.size() };
+            for(auto const& cn : constraints)
+            {
+                for(auto const& term : cn.expression().terms())
+                {
+                    auto const id = _getVarSymbol(term.variable()).id;
+                    if(id >= bulk.uses.size())
+                        bulk.uses.resize(id + 1, 0);
+                    bulk.uses[id]++;
+                }
+            }
+            bulk.seen.resize(bulk.uses.size(), false);
+
+            _flushSuggestions();
+            auto const outer = _batch;
+            _batch = true;
+            auto status = STATUS_OK;
+            for(auto const& cn : constraints)
+            {
+                if((status = _addConstraint(cn, &bulk)))
+                    break;
+            }
+
+            _batch = outer;
+            _optimizeObjective();
+            return status;
+        }
+
+        // While set, addConstraint appends to `into` instead, so a caller building a set for addConstraints
+        // also gets the constraints made on the side (derived attributes). Edit variables are added right away.
+        void collect(std::vector<Constraint>* into) { _collect = into; }
+
+        Status removeConstraint(const Constraint& constraint)
+        {
+            if(_closed && _closed->has(constraint))
+                _materialize();
+
+            auto cn = _cns.find(constraint);
+            if(cn == _cns.end())
+                return STATUS_UNKNOWN_CONSTRAINT;
+
+            _flushSuggestions();
+            auto const tag = cn->second;
+            _cns.erase(cn);
+            _generation++;
+            _removeConstraintEffects(constraint, tag);
+
+            if(_rows[tag.marker.id])
+                _rows[tag.marker.id].reset();
+            else
+            {
+                auto leaving = _getMarkerLeavingRow(tag.marker);
+                if(!leaving.valid())
+                    AUTOLAYOUT_FAIL(kiwi::InternalSolverError("failed to find leaving row"));
+
+                // pivot the marker into the basis, then drop its row along with the constraint
+                auto row = std::move(_rows[leaving.id]);
+                row->solveFor(leaving, tag.marker);
+                _substitute(tag.marker, *row);
+                _touch(leaving.id);
+            }
+
+            _optimizeObjective();
+            return STATUS_OK;
+        }
+
+        bool hasConstraint(const Constraint& constraint) const
+        {
+            return _closed ? _closed->has(constraint) : _cns.find(constraint) != _cns.end();
+        }
+
+        // every constraint but the edit variables', in the order they went in (which their markers' ids follow)
+        std::vector<Constraint> constraints() const
+        {
+            if(_closed)
+                return _closed->constraints();
+
+            auto edits = std::set<Constraint>{};
+            for(auto const& kv : _edits)
+                edits.insert(kv.second.constraint);
+
+            auto byId = std::vector<std::pair<uint32_t, Constraint>>{};
+            byId.reserve(_cns.size());
+            for(auto const& [cn, tag] : _cns)
+            {
+                if(!edits.count(cn))
+                    byId.emplace_back(tag.marker.id, cn);
+            }
+            std::sort(byId.begin(), byId.end(), [](auto const& a, auto const& b){ return a.first < b.first; });
+
+            auto out = std::vector<Constraint>{};
+            out.reserve(byId.size());
+            for(auto const& kv : byId)
+                out.push_back(kv.second);
+            return out;
+        }
+
+        // edit variables' included
+        size_t constraintCount() const { return _closed ? _closed->size() + _closed->editCount() : _cns.size(); }
+
+        // how many constraints are solved in closed form: all of them until the tableau takes over, else none
+        size_t closedFormConstraints() const { return _closed ? _closed->size() : 0; }
+
+        struct Edit
+        {
+            Variable variable;
+            double strength;
+            double value;       // suggested
+        };
+
+        // in the order they were added
+        std::vector<Edit> editVariables() const
+        {
+            if(_closed)
+            {
+                auto out = std::vector<Edit>{};
+                for(auto const& edit : _closed->edits())
+                    out.push_back(Edit{ edit.variable, edit.strength, edit.value });
+                return out;
+            }
+
+            auto byId = std::vector<std::pair<uint32_t, Edit>>{};
+            byId.reserve(_edits.size());
+            for(auto const& [var, info] : _edits)
+                byId.emplace_back(info.tag.marker.id, Edit{ var, info.constraint.strength(), info.constant });
+            std::sort(byId.begin(), byId.end(), [](auto const& a, auto const& b){ return a.first < b.first; });
+
+            auto out = std::vector<Edit>{};
+            out.reserve(byId.size());
+            for(auto const& kv : byId)
+                out.push_back(kv.second);
+            return out;
+        }
+
+        // Removes one set of constraints and bulk-adds another, optimizing once. When at least half of the
+        // tableau goes, it is rebuilt from the constraints that stay instead of pivoting each one out.
+        // All or nothing: on failure the solver has the constraints it had before.
+        Status replaceConstraints(const std::vector<Constraint>& remove, const std::vector<Constraint>& add)
+        {
+            for(auto const& cn : remove)
+            {
+                if(!hasConstraint(cn))
+                    return STATUS_UNKNOWN_CONSTRAINT;
+            }
+            auto const skip = std::set<Constraint>(remove.begin(), remove.end());
+            for(auto const& cn : add)
+            {
+                if(hasConstraint(cn) && !skip.count(cn))
+                    return STATUS_DUPLICATE_CONSTRAINT;
+            }
+
+            if(!_closed && remove.size() * 2 < _cns.size() - _edits.size())
+            {
+                auto const outer = _batch;
+                _batch = true;
+                auto status = STATUS_OK;
+                auto removed = std::vector<Constraint>{};
+                for(auto const& cn : remove)
+                {
+                    if((status = removeConstraint(cn)))
+                        break;
+                    removed.push_back(cn);
+                }
+                if(!status && (status = addConstraints(add)))
+                {
+                    for(auto const& cn : add)
+                    {
+                        if(hasConstraint(cn))
+                            removeConstraint(cn);
+                    }
+                }
+                if(status)
+                    addConstraints(removed);
+                _batch = outer;
+                _optimizeObjective();
+                return status;
+            }
+
+            // the new ones first, as addConstraints callers put chains before the definitions they use
+            auto const before = constraints();
+            auto cns = add;
+            for(auto const& cn : before)
+            {
+                if(!skip.count(cn))
+                    cns.push_back(cn);
+            }
+
+            // a failing add would leave out the ones queued after it: start over from what there was
+            auto const status = _rebuild(cns);
+            if(status)
+                _rebuild(before);
+            return status;
+        }
+
+        void addEditVariable(const Variable& variable, double strength)
+        {
+            if(hasEditVariable(variable))
+                AUTOLAYOUT_FAIL(kiwi::InternalSolverError("duplicate edit variable"));
+
+            strength = kiwi::strength::clip(strength);
+            if(strength == kiwi::strength::required)
+                AUTOLAYOUT_FAIL(kiwi::BadRequiredStrength());
+
+            if(_closed)
+            {
+                if(_closed->addEdit(variable, strength))
+                    return;
+                _materialize();
+            }
+
+            auto cn = Constraint(Expression(variable), OP_EQ, strength);
+            _flushSuggestions();
+            _addConstraint(cn);
+            _optimizeObjective();
+            _edits.emplace(variable, EditInfo{ _cns[cn], cn, 0.0 });
+        }
+
+        void removeEditVariable(const Variable& variable)
+        {
+            if(_closed && _closed->hasEdit(variable))
+                _materialize();
+
+            auto it = _edits.find(variable);
+            if(it == _edits.end())
+                AUTOLAYOUT_FAIL(kiwi::InternalSolverError("unknown edit variable"));
+
+            removeConstraint(it->second.constraint);
+            _edits.erase(it);
+        }
+
+        bool hasEditVariable(const Variable& variable) const
+        {
+            return _closed ? _closed->hasEdit(variable) : _edits.find(variable) != _edits.end();
+        }
+
+        void suggestValue(const Variable& variable, double value)
+        {
+            if(_closed)
+            {
+                if(!_closed->hasEdit(variable))
+                    AUTOLAYOUT_FAIL(kiwi::InternalSolverError("unknown edit variable"));
+                if(value == _closed->editValue(variable))
+                {
+                    _stats.skippedSuggestions++;
+                    return;
+                }
+                _stats.suggestions++;
+                _closed->suggest(variable, value);
+                return;
+            }
+
+            auto it = _edits.find(variable);
+            if(it == _edits.end())
+                AUTOLAYOUT_FAIL(kiwi::InternalSolverError("unknown edit variable"));
+
+            if(value == it->second.constant)
+            {
+                _stats.skippedSuggestions++;
+                return;
+            }
+            _stats.suggestions++;
+
+            // the dual simplex needs an optimal basis to start from
+            if(_optimizePending)
+            {
+                _optimize(_objective);
+                _optimizePending = false;
+            }
+
+            auto& info = it->second;
+            auto const delta = value - info.constant;
+            info.constant = value;
+
+            if(auto* row = _rows[info.tag.marker.id].get())
+            {
+                if(row->add(-delta) < 0.0)
+                    _infeasibleRows.push_back(info.tag.marker);
+            }
+            else if(auto* row = _rows[info.tag.other.id].get())
+            {
+                if(row->add(delta) < 0.0)
+                    _infeasibleRows.push_back(info.tag.other);
+            }
+            else if(_suggestDepth)
+                _markerDeltas.emplace_back(info.tag.marker, delta);   // one pass over the rows for all of them, at flush
+            else
+                _applyMarkerDeltas({ { info.tag.marker, delta } });
+
+            if(_suggestDepth)
+                _dualPending = true;
+            else
+                _dualOptimize();
+        }
+
+        // Suggestions up to the matching endSuggest() only shift row constants; one dual optimization then
+        // re-solves for all of them. Adding or removing constraints meanwhile re-solves first. Nests.
+        void beginSuggest() { _suggestDepth++; }
+
+        // Captures the current optimal basis as a Parametric of edits (all edit variables) for outputs.
+        // Outputs the solver doesn't know are constant.
+        Parametric parametric(const std::vector<Variable>& edits, const std::vector<Variable>& outputs)
+        {
+            if(_closed)
+                _materialize();
+            _flushSuggestions();
+            if(_optimizePending)
+            {
+                _optimize(_objective);
+                _optimizePending = false;
+            }
+
+            auto p = Parametric{};
+            auto outputOf = std::unordered_map<uint32_t, uint32_t>{};     // basic external symbol id -> output
+            for(uint32_t i=0; i<outputs.size(); i++)
+            {
+                auto it = _vars.find(outputs[i]);
+                auto const* row = it != _vars.end() ? _rows[it->second.id].get() : nullptr;
+                p._outBase.push_back(row ? row->constant() : it != _vars.end() ? 0.0 : _values->value(outputs[i]));
+                if(row)
+                    outputOf.emplace(it->second.id, i);
+            }
+
+            auto rowOf = std::unordered_map<uint32_t, uint32_t>{};
+            auto affect = [&](uint32_t e, uint32_t id, double coeff)
+            {
+                if(_types[id] == Symbol::SYM_EXTERNAL)
+                {
+                    auto out = outputOf.find(id);
+                    if(out != outputOf.end())
+                        p._outTerms[e].emplace_back(out->second, coeff);
+                    return;
+                }
+
+                auto [it, added] = rowOf.emplace(id, (uint32_t)p._rowBase.size());
+                if(added)
+                    p._rowBase.push_back(_rows[id]->constant());
+                p._rowTerms[e].emplace_back(it->second, coeff);
+            };
+
+            p._outTerms.resize(edits.size());
+            p._rowTerms.resize(edits.size());
+            for(uint32_t e=0; e<edits.size(); e++)
+            {
+                auto it = _edits.find(edits[e]);
+                if(it == _edits.end())
+                    AUTOLAYOUT_FAIL(kiwi::InternalSolverError("unknown edit variable"));
+
+                // as suggestValue moves the rows
+                auto const& info = it->second;
+                p._base.push_back(info.constant);
+                if(_rows[info.tag.marker.id])
+                    affect(e, info.tag.marker.id, -1.0);
+                else if(_rows[info.tag.other.id])
+                    affect(e, info.tag.other.id, 1.0);
+                else
+                {
+                    for(uint32_t id=1; id<_rows.size(); id++)
+                    {
+                        auto const coeff = _rows[id] ? _rows[id]->coefficientFor(info.tag.marker) : 0.0;
+                        if(coeff != 0.0)
+                            affect(e, id, coeff);
+                    }
+                }
+            }
+            return p;
+        }
+
+        void endSuggest()
+        {
+            if(_suggestDepth == 0 || --_suggestDepth > 0)
+                return;
+            _flushSuggestions();
+        }
+
+        void suggestValues(const std::vector<std::pair<Variable, double>>& values)
+        {
+            beginSuggest();
+            for(auto const& [variable, value] : values)
+                suggestValue(variable, value);
+            endSuggest();
+        }
+
+        // writes back only the variables whose row changed (or that entered or left the basis) since the last call
+        void updateVariables()
+        {
+            // an undetermined variable: the simplex picks its value
+            if(_closed && !_closed->complete())
+                _materialize();
+            if(_closed)
+            {
+                (_closed->dirty() ? _stats.updates : _stats.skippedUpdates)++;
+                if(_closed->dirty())
+                    _closed->solve();
+                return;
+            }
+
+            _flushSuggestions();
+            if(_dirtyList.empty())
+            {
+                _stats.skippedUpdates++;
+                return;
+            }
+            _stats.updates++;
+
+            for(auto id : _dirtyList)
+            {
+                auto* row = _rows[id].get();
+                _values->setValue(_variables[id], row ? row->constant() : 0.0);
+                _dirty[id] = false;
+            }
+            _dirtyList.clear();
+        }
+
+        // whether updateVariables would write anything back
+        bool dirty() const { return _closed ? _closed->dirty() : !_dirtyList.empty() || _dualPending; }
+
+        const Stats& stats() const { return _stats; }
+
+        uint64_t generation() const { return _generation; }
+
+        // the variables' values were overwritten from outside; the next updateVariables writes back all of them
+        void invalidateVariables()
+        {
+            if(_closed)
+                _closed->invalidate();
+            for(auto const& kv : _vars)
+                _touch(kv.second.id);
+        }
+
+        // Until commit(), add/remove keep the tableau feasible but skip the objective optimization.
+        void beginBatch() { _batch = true; }
+
+        void commit()
+        {
+            _flushSuggestions();
+            _batch = false;
+            _optimizeObjective();
+        }
+
+        bool inBatch() const { return _batch; }
+
+        // hands the closed form, if any, over to the tableau now
+        void materialize()
+        {
+            if(_closed)
+                _materialize();
+        }
+
+        // commit() in installments: optimizes with at most `pivots` pivots (taking off those it made) and returns
+        // false if it ran out first. The batch stays open then, with the tableau feasible but not yet optimal.
+        bool commitSome(size_t& pivots)
+        {
+            _flushSuggestions();
+            if(_optimizePending && !_optimize(_objective, &pivots))
+                return false;
+
+            _batch = _optimizePending = false;
+            return true;
+        }
+
+        // Symbols are never reused: every constraint added leaves its markers' slots behind once removed, and a
+        // removed constraint's variables stay. compact() drops what no constraint left refers to and renumbers the
+        // rest in the same order, so the tableau, and what it solves to, stay as they were. Returns bytes reclaimed.
+        size_t compact()
+        {
+            if(_closed)
+                return 0;   // a closed form takes no removals (they hand it to the tableau)
+
+            auto const before = memoryBytes();
+            auto const n = (uint32_t)_types.size();
+            auto keep = std::vector<bool>(n, false);
+            auto mark = [&](Symbol sym){ if(sym.valid()) keep[sym.id] = true; };
+
+            for(auto const& [cn, tag] : _cns)
+            {
+                mark(tag.marker);
+                mark(tag.other);
+                for(auto const& term : cn.expression().terms())
+                {
+                    auto it = _vars.find(term.variable());
+                    if(it != _vars.end())
+                        mark(it->second);
+                }
+            }
+
+            // a basic variable no constraint mentions any more: no other row refers to it, so its row can go
+            for(auto const& [var, sym] : _vars)
+            {
+                if(!keep[sym.id] && _rows[sym.id])
+                {
+                    if(_dirty[sym.id])
+                        _values->setValue(var, _rows[sym.id]->constant());
+                    _dirty[sym.id] = false;
+                    _rows[sym.id].reset();
+                }
+            }
+
+            for(uint32_t id=1; id<n; id++)
+            {
+                if(!_rows[id])
+                    continue;
+                keep[id] = true;
+                for(auto const& cell : _rows[id]->cells())
+                    keep[cell.sym.id] = true;
+            }
+            for(auto const& cell : _objective.cells())
+                keep[cell.sym.id] = true;
+            for(auto const& [sym, delta] : _markerDeltas)
+                keep[sym.id] = true;
+            for(auto sym : _infeasibleRows)
+                keep[sym.id] = true;
+
+            // then the variables in no row either, as updateVariables would have left them
+            for(auto it = _vars.begin(); it != _vars.end();)
+            {
+                if(keep[it->second.id])
+                {
+                    ++it;
+                    continue;
+                }
+                if(_dirty[it->second.id])
+                    _values->setValue(it->first, 0.0);
+                it = _vars.erase(it);
+            }
+
+            auto ids = std::vector<uint32_t>(n, 0);
+            auto live = uint32_t{1};
+            for(uint32_t id=1; id<n; id++)
+            {
+                if(keep[id])
+                    ids[id] = live++;
+            }
+
+            auto rows = std::vector<RowPtr>(live);
+            auto types = std::vector<Symbol::Type>(live, Symbol::SYM_INVALID);
+            auto variables = std::vector<Variable>(live);
+            auto dirty = std::vector<bool>(live, false);
+            for(uint32_t id=1; id<n; id++)
+            {
+                if(!keep[id])
+                    continue;
+                rows[ids[id]] = std::move(_rows[id]);
+                types[ids[id]] = _types[id];
+                variables[ids[id]] = _variables[id];
+                dirty[ids[id]] = _dirty[id];
+                if(auto* row = rows[ids[id]].get())
+                    row->renumber(ids);
+            }
+            _rows = std::move(rows);
+            _types = std::move(types);
+            _variables = std::move(variables);
+            _dirty = std::move(dirty);
+            _objective.renumber(ids);
+
+            auto remap = [&](Symbol& sym){ sym.id = ids[sym.id]; };
+            for(auto& [cn, tag] : _cns)
+            {
+                remap(tag.marker);
+                remap(tag.other);
+            }
+            for(auto& [var, info] : _edits)
+            {
+                remap(info.tag.marker);
+                remap(info.tag.other);
+            }
+            for(auto& [var, sym] : _vars)
+                remap(sym);
+            for(auto& [sym, delta] : _markerDeltas)
+                remap(sym);
+            for(auto& sym : _infeasibleRows)
+                remap(sym);
+
+            auto dirtyList = std::vector<uint32_t>{};
+            dirtyList.reserve(_dirtyList.size());
+            for(auto id : _dirtyList)
+            {
+                if(keep[id])
+                    dirtyList.push_back(ids[id]);
+            }
+            _dirtyList = std::move(dirtyList);
+            _dirtyList.shrink_to_fit();
+            _infeasibleRows.shrink_to_fit();
+            _markerDeltas.shrink_to_fit();
+
+            auto const after = memoryBytes();
+            return before > after ? before - after : 0;
+        }
+
+        // symbol slots, live or not
+        size_t symbolCount() const { return _types.size(); }
+
+        // more than factor times the symbols live constraints can have: compact() would reclaim most
+        bool wasteful(double factor) const
+        {
+            return !_closed && _types.size() > 1024 && (double)_types.size() > factor * (double)(_vars.size() + 2 * _cns.size() + 1);
+        }
+
+        // what the tableau, or the closed form, holds on to: vectors by capacity, rows, and map nodes by an estimate
+        size_t memoryBytes() const
+        {
+            auto const node = 4 * sizeof(void*);
+            auto bytes = sizeof(Solver) + _cns.size() * (node + sizeof(*_cns.begin())) + _vars.size() * (node + sizeof(*_vars.begin()))
+                    + _edits.size() * (node + sizeof(*_edits.begin()));
+            bytes += _rows.capacity() * sizeof(RowPtr) + _types.capacity() * sizeof(Symbol::Type) + _variables.capacity() * sizeof(Variable)
+                    + _dirty.capacity() / 8 + _dirtyList.capacity() * sizeof(uint32_t) + _infeasibleRows.capacity() * sizeof(Symbol)
+                    + _markerDeltas.capacity() * sizeof(_markerDeltas[0]);
+            for(auto const& row : _rows)
+            {
+                if(row)
+                    bytes += row->memoryBytes();
+            }
+            bytes += _objective.memoryBytes() - sizeof(Row);
+            if(_closed)
+                bytes += _closed->memoryBytes();
+            return bytes;
+        }
+
+        void reset()
+        {
+            _cns.clear();
+            _vars.clear();
+            _edits.clear();
+            _generation++;
+            _rows.clear();
+            _types.clear();
+            _variables.clear();
+            _dirty.clear();
+            _dirtyList.clear();
+            _infeasibleRows.clear();
+            _objective = Row{};
+            _artificial.reset();
+            _batch = _optimizePending = false;
+            _collect = nullptr;
+            _suggestDepth = 0;
+            _dualPending = false;
+            _markerDeltas.clear();
+            _closed = _closedForm ? std::make_unique<ClosedForm>(*_values, _arena) : nullptr;
+
+            // id 0 is the invalid symbol
+            _rows.emplace_back();
+            _types.push_back(Symbol::SYM_INVALID);
+            _variables.emplace_back();
+            _dirty.push_back(false);
+        }
+
+    private:
+        // the tableau made over from cns and the edit variables there are, their suggestions kept
+        Status _rebuild(const std::vector<Constraint>& cns)
+        {
+            _flushSuggestions();
+            auto const edits = editVariables();
+            auto const batch = _batch;
+            auto const suggestDepth = _suggestDepth;
+            reset();
+
+            // edits first, while suggesting is only a row shift
+            auto const stats = _stats;
+            for(auto const& edit : edits)
+            {
+                addEditVariable(edit.variable, edit.strength);
+                suggestValue(edit.variable, edit.value);
+            }
+            _stats = stats;
+
+            _batch = true;
+            auto const status = addConstraints(cns);
+            _batch = batch;
+            _suggestDepth = suggestDepth;
+            invalidateVariables();
+            _optimizeObjective();
+            return status;
+        }
+
+        // the tableau takes over from the closed form: edits first, as _rebuild does, then the
+        // constraints in the order they went in
+        void _materialize()
+        {
+            auto closed = std::move(_closed);
+            auto const stats = _stats;
+            for(auto const& edit : closed->edits())
+            {
+                addEditVariable(edit.variable, edit.strength);
+                suggestValue(edit.variable, edit.value);
+            }
+            _stats = stats;
+
+            addConstraints(closed->constraints());
+            invalidateVariables();
+        }
+
+        // adds constraints to the closed form while they fit it, counting them in taken; none unless all are
+        // equalities, so a set with an inequality goes to the tableau in one bulk load
+        Status _addClosed(const std::vector<Constraint>& constraints, size_t& taken)
+        {
+            for(auto const& cn : constraints)
+            {
+                if(cn.op() != OP_EQ)
+                    return STATUS_OK;
+            }
+
+            auto status = STATUS_OK;
+            for(auto const& cn : constraints)
+            {
+                if(_closed->has(cn))
+                {
+                    status = STATUS_DUPLICATE_CONSTRAINT;
+                    break;
+                }
+                if(!_closed->add(cn))
+                    break;
+                taken++;
+            }
+            _generation++;
+            return status;
+        }
+
+        Status _addConstraint(const Constraint& constraint, Bulk* bulk = nullptr)
+        {
+            if(_cns.find(constraint) != _cns.end())
+                return STATUS_DUPLICATE_CONSTRAINT;
+
+            auto const& terms = constraint.expression().terms();
+            if(bulk)
+            {
+                for(auto const& term : terms)
+                    bulk->uses[_vars[term.variable()].id]--;
+            }
+
+            auto const firstNew = (uint32_t)_types.size();
+            auto tag = Tag{};
+            auto row = _createRow(constraint, tag);
+            auto subject = _chooseSubject(*row, tag, bulk);
+
+            if(!subject.valid() && _allDummies(*row))
+            {
+                if(!Row::nearZero(row->constant()))
+                    return STATUS_UNSATISFIABLE_CONSTRAINT;
+                subject = tag.marker;
+            }
+
+            if(!subject.valid())
+            {
+                if(!_addWithArtificialVariable(*row))
+                    return STATUS_UNSATISFIABLE_CONSTRAINT;
+            }
+            else
+            {
+                row->solveFor(subject);
+                // a variable no row has referenced yet occurs in no other row (error markers are in the objective)
+                auto const fresh = subject.type == Symbol::SYM_EXTERNAL
+                        && (subject.id >= firstNew || (bulk && bulk->fresh(subject)));
+                if(!fresh)
+                    _substitute(subject, *row);
+                _rows[subject.id] = std::move(row);
+                _touch(subject.id);
+            }
+
+            if(bulk)
+            {
+                for(auto const& term : terms)
+                    bulk->seen[_vars[term.variable()].id] = true;
+            }
+
+            _cns[constraint] = tag;
+            _generation++;
+            return STATUS_OK;
+        }
+
+        Symbol _newSymbol(Symbol::Type type)
+        {
+            auto sym = Symbol{ (uint32_t)_types.size(), type };
+            _types.push_back(type);
+            _rows.emplace_back();
+            _variables.emplace_back();
+            _dirty.push_back(false);
+            return sym;
+        }
+
+        Symbol _getVarSymbol(const Variable& variable)
+        {
+            auto it = _vars.find(variable);
+            if(it != _vars.end())
+                return it->second;
+
+            auto sym = _newSymbol(Symbol::SYM_EXTERNAL);
+            _vars.emplace(variable, sym);
+            _variables[sym.id] = variable;
+            _touch(sym.id);
+            return sym;
+        }
+
+        template<typename... Args>
+        RowPtr _newRow(Args&&... args)
+        {
+            return RowPtr(arena_new<Row>(_arena, std::forward<Args>(args)...), ArenaDelete<Row>{ _arena });
+        }
+
+        RowPtr _createRow(const Constraint& constraint, Tag& tag)
+        {
+            auto const& expr = constraint.expression();
+            auto row = _newRow(expr.constant(), _arena);
+
+            for(auto const& term : expr.terms())
+            {
+                if(Row::nearZero(term.coefficient()))
+                    continue;
+
+                auto sym = _getVarSymbol(term.variable());
+                if(auto* basic = _rows[sym.id].get())
+                    row->insert(*basic, term.coefficient());
+                else
+                    row->insert(sym, term.coefficient());
+            }
+
+            switch(constraint.op())
+            {
+                case OP_LE:
+                case OP_GE:
+                {
+                    auto const coeff = constraint.op() == OP_LE ? 1.0 : -1.0;
+                    auto slack = _newSymbol(Symbol::SYM_SLACK);
+                    tag.marker = slack;
+                    row->insert(slack, coeff);
+
+                    if(constraint.strength() < kiwi::strength::required)
+                    {
+                        auto error = _newSymbol(Symbol::SYM_ERROR);
+                        tag.other = error;
+                        row->insert(error, -coeff);
+                        _objective.insert(error, constraint.strength());
+                    }
+                    break;
+                }
+                case OP_EQ:
+                {
+                    if(constraint.strength() < kiwi::strength::required)
+                    {
+                        auto errplus = _newSymbol(Symbol::SYM_ERROR);
+                        auto errminus = _newSymbol(Symbol::SYM_ERROR);
+                        tag.marker = errplus;
+                        tag.other = errminus;
+                        row->insert(errplus, -1.0);
+                        row->insert(errminus, 1.0);
+                        _objective.insert(errplus, constraint.strength());
+                        _objective.insert(errminus, constraint.strength());
+                    }
+                    else
+                    {
+                        auto dummy = _newSymbol(Symbol::SYM_DUMMY);
+                        tag.marker = dummy;
+                        row->insert(dummy);
+                    }
+                    break;
+                }
+            }
+
+            if(row->constant() < 0.0)
+                row->reverseSign();
+
+            return row;
+        }
+
+        // kiwi's rule: the first external symbol, else a marker with a negative coefficient.
+        // In a bulk load, prefer an external symbol no row has referenced yet (solving for it substitutes into nothing),
+        // then the one with the fewest references still to come (its row gets copied into those).
+        static Symbol _chooseSubject(const Row& row, const Tag& tag, const Bulk* bulk = nullptr)
+        {
+            auto best = Symbol{};
+            auto bestScore = UINT64_MAX;
+            for(auto const& cell : row.cells())
+            {
+                if(cell.sym.type != Symbol::SYM_EXTERNAL)
+                    continue;
+                if(!bulk)
+                    return cell.sym;
+
+                auto const uses = cell.sym.id < bulk->uses.size() ? bulk->uses[cell.sym.id] : 0;
+                auto const score = (bulk->fresh(cell.sym) ? 0 : 1ull << 32) | uses;
+                if(score < bestScore)
+                {
+                    best = cell.sym;
+                    if((bestScore = score) == 0)
+                        break;
+                }
+            }
+            if(best.valid())
+                return best;
+
+            if(tag.marker.restricted() && row.coefficientFor(tag.marker) < 0.0)
+                return tag.marker;
+            if(tag.other.restricted() && row.coefficientFor(tag.other) < 0.0)
+                return tag.other;
+            return {};
+        }
+
+        bool _addWithArtificialVariable(const Row& row)
+        {
+            auto art = _newSymbol(Symbol::SYM_SLACK);
+            _rows[art.id] = _newRow(row);
+            _artificial = _newRow(row);
+
+            _optimize(*_artificial);
+            auto const success = Row::nearZero(_artificial->constant());
+            _artificial.reset();
+
+            if(auto artRow = std::move(_rows[art.id]))
+            {
+                if(artRow->cells().empty())
+                    return success;
+
+                auto entering = _anyPivotableSymbol(*artRow);
+                if(!entering.valid())
+                    return false;
+
+                artRow->solveFor(art, entering);
+                _substitute(entering, *artRow);
+                _rows[entering.id] = std::move(artRow);
+                _touch(entering.id);
+            }
+
+            for(auto& r : _rows)
+            {
+                if(r)
+                    r->remove(art);
+            }
+            _objective.remove(art);
+            return success;
+        }
+
+        void _substitute(Symbol sym, const Row& row)
+        {
+            for(uint32_t id=1; id<_rows.size(); id++)
+            {
+                auto* r = _rows[id].get();
+                if(!r)
+                    continue;
+
+                if(r->substitute(sym, row))
+                    _touch(id);
+                if(_types[id] != Symbol::SYM_EXTERNAL && r->constant() < 0.0)
+                    _infeasibleRows.push_back(Symbol{ id, _types[id] });
+            }
+
+            _objective.substitute(sym, row);
+            if(_artificial)
+                _artificial->substitute(sym, row);
+        }
+
+        void _optimizeObjective()
+        {
+            _optimizePending = true;
+            if(_batch)
+                return;
+
+            _optimize(_objective);
+            _optimizePending = false;
+        }
+
+        void _flushSuggestions()
+        {
+            if(!_dualPending)
+                return;
+
+            if(!_markerDeltas.empty())
+            {
+                _applyMarkerDeltas(_markerDeltas);
+                _markerDeltas.clear();
+            }
+            _dualPending = false;
+            _dualOptimize();
+        }
+
+        // each row's constant moves by delta times its coefficient for the edit's marker
+        void _applyMarkerDeltas(const std::vector<std::pair<Symbol, double>>& deltas)
+        {
+            if(deltas.size() == 1)
+            {
+                auto const [marker, delta] = deltas.front();
+                for(uint32_t id=1; id<_rows.size(); id++)
+                {
+                    auto* row = _rows[id].get();
+                    if(!row)
+                        continue;
+
+                    auto const coeff = row->coefficientFor(marker);
+                    if(coeff == 0.0)
+                        continue;
+
+                    _touch(id);
+                    if(row->add(delta * coeff) < 0.0 && _types[id] != Symbol::SYM_EXTERNAL)
+                        _infeasibleRows.push_back(Symbol{ id, _types[id] });
+                }
+                return;
+            }
+
+            auto byId = std::vector<double>(_types.size(), 0.0);
+            for(auto const& [marker, delta] : deltas)
+                byId[marker.id] += delta;
+
+            for(uint32_t id=1; id<_rows.size(); id++)
+            {
+                auto* row = _rows[id].get();
+                if(!row)
+                    continue;
+
+                auto shift = 0.0;
+                for(auto const& cell : row->cells())
+                    shift += byId[cell.sym.id] * cell.coeff;
+
+                if(shift == 0.0)
+                    continue;
+
+                _touch(id);
+                if(row->add(shift) < 0.0 && _types[id] != Symbol::SYM_EXTERNAL)
+                    _infeasibleRows.push_back(Symbol{ id, _types[id] });
+            }
+        }
+
+        // pivots: a budget to take each pivot off; false once it is out and the objective isn't optimal yet
+        bool _optimize(const Row& objective, size_t* pivots = nullptr)
+        {
+            while(true)
+            {
+                auto entering = _getEnteringSymbol(objective);
+                if(!entering.valid())
+                    return true;
+                if(pivots && (*pivots)-- == 0)
+                {
+                    *pivots = 0;
+                    return false;
+                }
+
+                auto leaving = _getLeavingRow(entering);
+                if(!leaving.valid())
+                    AUTOLAYOUT_FAIL(kiwi::InternalSolverError("The objective is unbounded."));
+
+                _pivot(leaving, entering);
+            }
+        }
+
+        void _dualOptimize()
+        {
+            while(!_infeasibleRows.empty())
+            {
+                auto leaving = _infeasibleRows.back();
+                _infeasibleRows.pop_back();
+
+                auto* row = _rows[leaving.id].get();
+                if(!row || Row::nearZero(row->constant()) || row->constant() >= 0.0)
+                    continue;
+
+                auto entering = _getDualEnteringSymbol(*row);
+                if(!entering.valid())
+                    AUTOLAYOUT_FAIL(kiwi::InternalSolverError("Dual optimize failed."));
+
+                _pivot(leaving, entering);
+            }
+        }
+
+        void _pivot(Symbol leaving, Symbol entering)
+        {
+            auto row = std::move(_rows[leaving.id]);
+            row->solveFor(leaving, entering);
+            _substitute(entering, *row);
+            _rows[entering.id] = std::move(row);
+            _touch(leaving.id);
+            _touch(entering.id);
+        }
+
+        void _touch(uint32_t id)
+        {
+            if(_types[id] == Symbol::SYM_EXTERNAL && !_dirty[id])
+            {
+                _dirty[id] = true;
+                _dirtyList.push_back(id);
+            }
+        }
+
+        static Symbol _getEnteringSymbol(const Row& objective)
+        {
+            for(auto const& cell : objective.cells())
+            {
+                if(cell.sym.type != Symbol::SYM_DUMMY && cell.coeff < 0.0)
+                    return cell.sym;
+            }
+            return {};
+        }
+
+        Symbol _getDualEnteringSymbol(const Row& row) const
+        {
+            auto entering = Symbol{};
+            auto ratio = std::numeric_limits<double>::max();
+
+            for(auto const& cell : row.cells())
+            {
+                if(cell.coeff > 0.0 && cell.sym.type != Symbol::SYM_DUMMY)
+                {
+                    auto const r = _objective.coefficientFor(cell.sym) / cell.coeff;
+                    if(r < ratio)
+                    {
+                        ratio = r;
+                        entering = cell.sym;
+                    }
+                }
+            }
+            return entering;
+        }
+
+        static Symbol _anyPivotableSymbol(const Row& row)
+        {
+            for(auto const& cell : row.cells())
+            {
+                if(cell.sym.restricted())
+                    return cell.sym;
+            }
+            return {};
+        }
+
+        Symbol _getLeavingRow(Symbol entering) const
+        {
+            auto found = Symbol{};
+            auto ratio = std::numeric_limits<double>::max();
+
+            for(uint32_t id=1; id<_rows.size(); id++)
+            {
+                auto* row = _rows[id].get();
+                if(!row || _types[id] == Symbol::SYM_EXTERNAL)
+                    continue;
+
+                auto const coeff = row->coefficientFor(entering);
+                if(coeff < 0.0)
+                {
+                    auto const r = -row->constant() / coeff;
+                    if(r < ratio)
+                    {
+                        ratio = r;
+                        found = Symbol{ id, _types[id] };
+                    }
+                }
+            }
+            return found;
+        }
+
+        // the row to pivot out when removing a non-basic marker: restricted rows by min ratio, external last
+        Symbol _getMarkerLeavingRow(Symbol marker) const
+        {
+            auto const dmax = std::numeric_limits<double>::max();
+            auto r1 = dmax, r2 = dmax;
+            auto first = Symbol{}, second = Symbol{}, third = Symbol{};
+
+            for(uint32_t id=1; id<_rows.size(); id++)
+            {
+                auto* row = _rows[id].get();
+                if(!row)
+                    continue;
+
+                auto const coeff = row->coefficientFor(marker);
+                if(coeff == 0.0)
+                    continue;
+
+                auto const sym = Symbol{ id, _types[id] };
+                if(sym.type == Symbol::SYM_EXTERNAL)
+                    third = sym;
+                else if(coeff < 0.0)
+                {
+                    auto const r = -row->constant() / coeff;
+                    if(r < r1)
+                    {
+                        r1 = r;
+                        first = sym;
+                    }
+                }
+                else
+                {
+                    auto const r = row->constant() / coeff;
+                    if(r < r2)
+                    {
+                        r2 = r;
+                        second = sym;
+                    }
+                }
+            }
+
+            return first.valid() ? first : (second.valid() ? second : third);
+        }
+
+        void _removeConstraintEffects(const Constraint& constraint, const Tag& tag)
+        {
+            if(tag.marker.type == Symbol::SYM_ERROR)
+                _removeMarkerEffects(tag.marker, constraint.strength());
+            if(tag.other.type == Symbol::SYM_ERROR)
+                _removeMarkerEffects(tag.other, constraint.strength());
+        }
+
+        void _removeMarkerEffects(Symbol marker, double strength)
+        {
+            if(auto* row = _rows[marker.id].get())
+                _objective.insert(*row, -strength);
+            else
+                _objective.insert(marker, -strength);
+        }
+
+        static bool _allDummies(const Row& row)
+        {
+            for(auto const& cell : row.cells())
+            {
+                if(cell.sym.type != Symbol::SYM_DUMMY)
+                    return false;
+            }
+            return true;
+        }
+    };
+}
@@ -0,0 +1,613 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <vector>
+#include "variable.h"
+#include "solver.h"
+
+namespace autolayout
+{
+    // One Solver per connected component of the constraints over their variables: H: and V: lines never share
+    // a variable, and neither do disconnected clusters. A suggestion re-optimizes only its component's tableau,
+    // pivots substitute into its rows only, and updateVariables skips the components that didn't change.
+    // Components merge when a constraint connects them; removing constraints doesn't split them until reset().
+    class SolverSet
+    {
+    public:
+        using Stats = Solver::Stats;
+
+        // Solver::Parametric per component, scattered into the caller's edit and output order
+        class Parametric
+        {
+        public:
+            bool evaluate(const double* values, double* outputs) const
+            {
+                for(auto const& [index, value] : _constants)
+                    outputs[index] = value;
+
+                for(auto const& part : _parts)
+                {
+                    for(size_t i=0; i<part.edits.size(); i++)
+                        _values[i] = values[part.edits[i]];
+                    if(!part.basis.evaluate(_values.data(), _outputs.data()))
+                        return false;
+                    for(size_t i=0; i<part.outputs.size(); i++)
+                        outputs[part.outputs[i]] = _outputs[i];
+                }
+                return true;
+            }
+
+        private:
+            struct Part
+            {
+                Solver::Parametric basis;
+                std::vector<uint32_t> edits;        // caller's edit index by the component's
+                std::vector<uint32_t> outputs;      // caller's output index by the component's
+            };
+            std::vector<Part> _parts;
+            std::vector<std::pair<uint32_t, double>> _constants;    // outputs no component knows
+            mutable std::vector<double> _values;
+            mutable std::vector<double> _outputs;
+            friend class SolverSet;
+        };
+
+        SolverSet() { reset(); }
+
+        // where the components' solvers and the constraint map allocate (see View::setArena), from empty on
+        // re-adds the edit variables (with their suggestions) and constraints there are from the new arena; like
+        // reset(), it closes any batch or suggest (the View refuses while one is open)
+        void setArena(Arena* arena)
+        {
+            auto cns = std::vector<Constraint>{};
+            for(auto& kv : _cns)
+                cns.push_back(kv.first);
+            auto edits = std::vector<Solver::Edit>{};
+            for(auto* part : _live)
+            {
+                for(auto const& edit : part->solver->editVariables())
+                    edits.push_back(edit);
+            }
+
+            reset();
+            _arena = arena;
+            _cns = arena_container<decltype(_cns)>(arena);
+            // edits first, while suggesting is only a row shift
+            for(auto const& edit : edits)
+            {
+                addEditVariable(edit.variable, edit.strength);
+                suggestValue(edit.variable, edit.value);
+            }
+            addConstraints(cns);
+        }
+
+        Status addConstraint(const Constraint& constraint)
+        {
+            if(_collect)
+            {
+                _collect->push_back(constraint);
+                return STATUS_OK;
+            }
+            if(hasConstraint(constraint))
+                return STATUS_DUPLICATE_CONSTRAINT;
+
+            auto* part = _partFor(constraint);
+            if(auto const status = part->solver->addConstraint(constraint))
+                return status;
+            _assign(constraint, part);
+            _generation++;
+            return STATUS_OK;
+        }
+
+        // bulk load (see Solver::addConstraints), split by component first; each keeps the caller's order.
+        // A failing component keeps what it took before the failing constraint; the others load in full.
+        Status addConstraints(const std::vector<Constraint>& constraints)
+        {
+            auto status = STATUS_OK;
+            for(auto& [part, cns] : _group(constraints))
+                status = _assignAll(part, cns, part->solver->addConstraints(cns), status);
+            _generation++;
+            return status;
+        }
+
+        void collect(std::vector<Constraint>* into) { _collect = into; }
+
+        Status removeConstraint(const Constraint& constraint)
+        {
+            auto it = _cns.find(constraint);
+            if(it == _cns.end())
+                return STATUS_UNKNOWN_CONSTRAINT;
+
+            auto* part = _find(it->second);
+            if(auto const status = part->solver->removeConstraint(constraint))
+                return status;
+            _cns.erase(it);
+            _generation++;
+            _autoCompactPart(part);
+            return STATUS_OK;
+        }
+
+        bool hasConstraint(const Constraint& constraint) const { return _cns.find(constraint) != _cns.end(); }
+
+        Status replaceConstraints(const std::vector<Constraint>& remove, const std::vector<Constraint>& add)
+        {
+            for(auto const& cn : remove)
+            {
+                if(_cns.find(cn) == _cns.end())
+                    return STATUS_UNKNOWN_CONSTRAINT;
+            }
+
+            auto changes = std::map<Part*, std::pair<std::vector<Constraint>, std::vector<Constraint>>>{};
+            for(auto& [part, cns] : _group(add))
+                changes[part].second = std::move(cns);
+            for(auto const& cn : remove)
+                changes[_find(_cns.at(cn))].first.push_back(cn);
+
+            // all or nothing, as each part's is: on a failure the parts that went through swap back
+            auto done = std::vector<Part*>{};
+            for(auto& [part, change] : changes)
+            {
+                if(auto const status = part->solver->replaceConstraints(change.first, change.second))
+                {
+                    for(auto* undo : done)
+                    {
+                        if(undo->solver->replaceConstraints(changes[undo].second, changes[undo].first))
+                            AUTOLAYOUT_FAIL(kiwi::InternalSolverError("constraints that were in the solver don't go back"));
+                    }
+                    return status;
+                }
+                done.push_back(part);
+            }
+
+            for(auto& [part, change] : changes)
+            {
+                for(auto const& cn : change.first)
+                    _cns.erase(cn);
+                for(auto const& cn : change.second)
+                    _assign(cn, part);
+                _autoCompactPart(part);
+            }
+            _generation++;
+            return STATUS_OK;
+        }
+
+        void addEditVariable(const Variable& variable, double strength)
+        {
+            auto* part = _partFor(Constraint(Expression(variable), OP_EQ, strength));
+            part->solver->addEditVariable(variable, strength);
+            _assign(variable, part->id);
+        }
+
+        void removeEditVariable(const Variable& variable)
+        {
+            auto* part = _partOf(variable);
+            if(!part)
+                AUTOLAYOUT_FAIL(kiwi::InternalSolverError("unknown edit variable"));
+            part->solver->removeEditVariable(variable);
+        }
+
+        bool hasEditVariable(const Variable& variable) const
+        {
+            auto* part = _partOf(variable);
+            return part && part->solver->hasEditVariable(variable);
+        }
+
+        void suggestValue(const Variable& variable, double value)
+        {
+            auto* part = _partOf(variable);
+            if(!part)
+                AUTOLAYOUT_FAIL(kiwi::InternalSolverError("unknown edit variable"));
+            part->solver->suggestValue(variable, value);
+        }
+
+        void beginSuggest()
+        {
+            _suggestDepth++;
+            for(auto* part : _live)
+                part->solver->beginSuggest();
+        }
+
+        void endSuggest()
+        {
+            if(_suggestDepth == 0)
+                return;
+            _suggestDepth--;
+            for(auto* part : _live)
+                part->solver->endSuggest();
+        }
+
+        int suggestDepth() const { return _suggestDepth; }
+
+        Parametric parametric(const std::vector<Variable>& edits, const std::vector<Variable>& outputs)
+        {
+            auto p = Parametric{};
+            auto byPart = std::map<Part*, std::pair<std::vector<Variable>, std::vector<Variable>>>{};
+            auto index = std::map<Part*, Parametric::Part>{};
+
+            for(uint32_t e=0; e<edits.size(); e++)
+            {
+                auto* part = _partOf(edits[e]);
+                if(!part)
+                    AUTOLAYOUT_FAIL(kiwi::InternalSolverError("unknown edit variable"));
+                byPart[part].first.push_back(edits[e]);
+                index[part].edits.push_back(e);
+            }
+            for(uint32_t o=0; o<outputs.size(); o++)
+            {
+                auto* part = _partOf(outputs[o]);
+                if(!part)
+                {
+                    p._constants.emplace_back(o, _variables.value(outputs[o]));
+                    continue;
+                }
+                byPart[part].second.push_back(outputs[o]);
+                index[part].outputs.push_back(o);
+            }
+
+            auto most = size_t{0};
+            for(auto& [part, vars] : byPart)
+            {
+                auto& entry = index[part];
+                entry.basis = part->solver->parametric(vars.first, vars.second);
+                most = std::max({ most, entry.edits.size(), entry.outputs.size() });
+                p._parts.push_back(std::move(entry));
+            }
+            p._values.resize(most);
+            p._outputs.resize(most);
+            return p;
+        }
+
+        void updateVariables()
+        {
+            auto any = false;
+            for(auto* part : _live)
+            {
+                if(part->solver->dirty())
+                {
+                    part->solver->updateVariables();
+                    any = true;
+                }
+            }
+            (any ? _stats.updates : _stats.skippedUpdates)++;
+        }
+
+        bool dirty() const
+        {
+            return std::any_of(_live.begin(), _live.end(), [](const Part* part){ return part->solver->dirty(); });
+        }
+
+        Stats stats() const
+        {
+            auto stats = _stats;
+            for(auto* part : _live)
+            {
+                stats.suggestions += part->solver->stats().suggestions;
+                stats.skippedSuggestions += part->solver->stats().skippedSuggestions;
+            }
+            return stats;
+        }
+
+        uint64_t generation() const { return _generation; }
+
+        void invalidateVariables()
+        {
+            for(auto* part : _live)
+                part->solver->invalidateVariables();
+        }
+
+        void beginBatch()
+        {
+            _batch = true;
+            for(auto* part : _live)
+                part->solver->beginBatch();
+        }
+
+        void commit()
+        {
+            _batch = false;
+            for(auto* part : _live)
+                part->solver->commit();
+        }
+
+        bool inBatch() const { return _batch; }
+
+        // Off: every component goes to the tableau now, and new ones start there. A closed form can only be
+        // handed over whole, so loading in installments (View::step) keeps out of it.
+        void setClosedForm(bool on)
+        {
+            _closedForm = on;
+            if(!on)
+            {
+                for(auto* part : _live)
+                    part->solver->materialize();
+            }
+        }
+
+        // commit() in installments, one component after the other (see Solver::commitSome)
+        bool commitSome(size_t& pivots)
+        {
+            for(auto* part : _live)
+            {
+                if(!part->solver->commitSome(pivots))
+                    return false;
+            }
+            _batch = false;
+            return true;
+        }
+
+        size_t componentCount() const { return _live.size(); }
+
+        // Solver::compact for the components wasteful by factor (all with 0), and drops the variables no constraint
+        // mentions any more; returns bytes reclaimed
+        size_t compact(double factor = 0)
+        {
+            auto reclaimed = size_t{0};
+            for(auto* part : _live)
+            {
+                if(factor == 0 || part->solver->wasteful(factor))
+                    reclaimed += part->solver->compact();
+            }
+            if(factor != 0 && !reclaimed)
+                return 0;
+
+            // so they don't join components when they come back
+            auto mentioned = std::vector<bool>(_vars.size(), false);
+            for(auto const& [cn, part] : _cns)
+            {
+                for(auto const& term : cn.expression().terms())
+                    mentioned[term.variable().id] = true;
+            }
+            for(uint32_t id=0; id<_vars.size(); id++)
+            {
+                if(_vars[id] != NONE && !mentioned[id] && !_find(_vars[id])->solver->hasEditVariable(Variable{ id }))
+                    _vars[id] = NONE;
+            }
+            return reclaimed;
+        }
+
+        // Removals compact a component once it is wasteful by factor (see Solver::wasteful); 0 turns it off
+        void setAutoCompact(double factor) { _autoCompact = factor; }
+        double autoCompact() const { return _autoCompact; }
+
+        // bytes the automatic compactions reclaimed, and how many there were
+        size_t autoCompacted() const { return _autoCompacted; }
+        uint64_t autoCompactions() const { return _autoCompactions; }
+
+        // whether compact(factor) would do anything
+        bool wasteful(double factor) const
+        {
+            for(auto* part : _live)
+            {
+                if(part->solver->wasteful(factor))
+                    return true;
+            }
+            return false;
+        }
+
+        size_t memoryBytes() const
+        {
+            auto const node = 4 * sizeof(void*);
+            auto bytes = sizeof(SolverSet) + _parts.capacity() * sizeof(void*) + _parts.size() * sizeof(Part) + _live.capacity() * sizeof(void*)
+                    + _parent.capacity() * sizeof(uint32_t) + _vars.capacity() * sizeof(uint32_t)
+                    + _variables.size() * sizeof(double) + _cns.size() * (node + sizeof(*_cns.begin()));
+            for(auto* part : _live)
+                bytes += part->solver->memoryBytes();
+            return bytes;
+        }
+
+        // constraints of the components still solved in closed form (see Solver)
+        size_t closedFormConstraints() const
+        {
+            auto count = size_t{0};
+            for(auto* part : _live)
+                count += part->solver->closedFormConstraints();
+            return count;
+        }
+
+        // where the View's variables get their ids and the solvers write their values (see VariableTable)
+        VariableTable& variables() { return _variables; }
+        const VariableTable& variables() const { return _variables; }
+        double value(Variable variable) const { return _variables.value(variable); }
+        void setValue(Variable variable, double value) { _variables.setValue(variable, value); }
+
+        void reset()
+        {
+            _parts.clear();
+            _live.clear();
+            _parent.clear();
+            _vars.clear();
+            _cns.clear();
+            _collect = nullptr;
+            _batch = false;
+            _suggestDepth = 0;
+            _generation++;
+        }
+
+    private:
+        struct Part
+        {
+            uint32_t id;
+            std::unique_ptr<Solver> solver;
+        };
+
+        std::vector<std::unique_ptr<Part>> _parts = {};     // by id, merged ones included
+        std::vector<Part*> _live = {};
+        std::vector<uint32_t> _parent = {};                 // by part id: the one it merged into, or itself
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        VariableTable _variables = {};                      // kept by reset(): the View's subviews keep theirs (see View::reset)
+        std::vector<uint32_t> _vars = {};                   // by variable id: part id, possibly merged since, or NONE
+        ArenaMap<Constraint, uint32_t> _cns = {};
+        Arena* _arena = nullptr;
+        std::vector<Constraint>* _collect = nullptr;
+        bool _batch = false;
+        bool _closedForm = true;
+        double _autoCompact = 4;
+        size_t _autoCompacted = 0;
+        uint64_t _autoCompactions = 0;
+        int _suggestDepth = 0;
+        uint64_t _generation = 0;
+        Stats _stats = {};                                  // updates, and the suggestions of merged parts
+
+        void _autoCompactPart(Part* part)
+        {
+            if(_autoCompact == 0 || !part->solver->wasteful(_autoCompact))
+                return;
+            _autoCompacted += part->solver->compact();
+            _autoCompactions++;
+        }
+
+        Part* _find(uint32_t id) const
+        {
+            while(_parent[id] != id)
+                id = _parent[id];
+            return _parts[id].get();
+        }
+
+        Part* _partOf(const Variable& variable) const
+        {
+            return variable.id < _vars.size() && _vars[variable.id] != NONE ? _find(_vars[variable.id]) : nullptr;
+        }
+
+        Part* _newPart()
+        {
+            auto id = (uint32_t)_parts.size();
+            _parts.push_back(std::make_unique<Part>(Part{ id, std::make_unique<Solver>(_variables, _closedForm, _arena) }));
+            _parent.push_back(id);
+
+            auto* part = _parts.back().get();
+            if(_batch)
+                part->solver->beginBatch();
+            for(int i=0; i<_suggestDepth; i++)
+                part->solver->beginSuggest();
+            _live.push_back(part);
+            return part;
+        }
+
+        void _assign(Variable variable, uint32_t part)
+        {
+            if(variable.id >= _vars.size())
+                _vars.resize(std::max<size_t>(variable.id + 1, _vars.size() * 2), NONE);
+            _vars[variable.id] = part;
+        }
+
+        void _assign(const Constraint& constraint, Part* part)
+        {
+            _cns[constraint] = part->id;
+            for(auto const& term : constraint.expression().terms())
+                _assign(term.variable(), part->id);
+        }
+
+        // assigns the constraints part's solver took (all of them unless result failed); the first failure wins
+        Status _assignAll(Part* part, const std::vector<Constraint>& cns, Status result, Status status)
+        {
+            for(auto const& cn : cns)
+            {
+                if(!result || part->solver->hasConstraint(cn))
+                    _assign(cn, part);
+            }
+            return status ? status : result;
+        }
+
+        // the component for a constraint about to be added, merging the ones it connects
+        Part* _partFor(const Constraint& constraint)
+        {
+            auto parts = std::vector<Part*>{};
+            for(auto const& term : constraint.expression().terms())
+            {
+                if(auto* part = _partOf(term.variable()))
+                    parts.push_back(part);
+            }
+            return parts.empty() ? _newPart() : _merge(parts);
+        }
+
+        // moves every other part's constraints and edit variables into the largest one
+        Part* _merge(std::vector<Part*> parts)
+        {
+            // by id, so the outcome doesn't depend on where the parts were allocated
+            std::sort(parts.begin(), parts.end(), [](const Part* a, const Part* b){ return a->id < b->id; });
+            parts.erase(std::unique(parts.begin(), parts.end()), parts.end());
+            auto* into = *std::max_element(parts.begin(), parts.end(), [](const Part* a, const Part* b)
+            {
+                return a->solver->constraintCount() < b->solver->constraintCount();
+            });
+
+            for(auto* part : parts)
+            {
+                if(part == into)
+                    continue;
+
+                // edits first: a closed form takes an edit only on a variable no constraint determines yet
+                for(auto const& edit : part->solver->editVariables())
+                {
+                    into->solver->addEditVariable(edit.variable, edit.strength);
+                    into->solver->suggestValue(edit.variable, edit.value);
+                }
+                // components share no variables, so what each took the union takes
+                if(into->solver->addConstraints(part->solver->constraints()))
+                    AUTOLAYOUT_FAIL(kiwi::InternalSolverError("merged components conflict"));
+
+                _stats.suggestions += part->solver->stats().suggestions;
+                _stats.skippedSuggestions += part->solver->stats().skippedSuggestions;
+                _parent[part->id] = into->id;
+                _live.erase(std::find(_live.begin(), _live.end(), part));
+                part->solver.reset();
+            }
+            into->solver->invalidateVariables();
+            return into;
+        }
+
+        // constraints by the component each goes into, creating and merging components as they connect
+        std::vector<std::pair<Part*, std::vector<Constraint>>> _group(const std::vector<Constraint>& constraints)
+        {
+            // union-find over the constraints, joined through shared variables and existing components
+            auto group = std::vector<uint32_t>(constraints.size());
+            std::iota(group.begin(), group.end(), 0);
+            auto root = [&](uint32_t i)
+            {
+                while(group[i] != i)
+                    i = group[i] = group[group[i]];
+                return i;
+            };
+
+            auto seen = std::map<Variable, uint32_t>{};
+            auto existing = std::map<uint32_t, uint32_t>{};     // part id -> a constraint joined to it
+            for(uint32_t i=0; i<constraints.size(); i++)
+            {
+                for(auto const& term : constraints[i].expression().terms())
+                {
+                    auto [it, added] = seen.emplace(term.variable(), i);
+                    if(!added)
+                        group[root(it->second)] = root(i);
+
+                    if(auto* part = _partOf(term.variable()))
+                    {
+                        auto [at, first] = existing.emplace(part->id, i);
+                        if(!first)
+                            group[root(at->second)] = root(i);
+                    }
+                }
+            }
+
+            auto partsOf = std::map<uint32_t, std::vector<Part*>>{};
+            for(auto const& [id, i] : existing)
+                partsOf[root(i)].push_back(_parts[id].get());
+
+            auto out = std::vector<std::pair<Part*, std::vector<Constraint>>>{};
+            auto slot = std::map<uint32_t, size_t>{};
+            for(uint32_t i=0; i<constraints.size(); i++)
+            {
+                auto [it, added] = slot.emplace(root(i), out.size());
+                if(added)
+                {
+                    auto parts = partsOf.find(it->first);
+                    out.emplace_back(parts == partsOf.end() ? _newPart() : _merge(parts->second), std::vector<Constraint>{});
+                }
+                out[it->second].second.push_back(constraints[i]);
+            }
+            return out;
+        }
+    };
+}
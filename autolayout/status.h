@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdlib>
+
+// Failures no call through the View can cause (a bug, not a bad layout): thrown as kiwi's exceptions, or with
+// exceptions disabled (-fno-exceptions), an abort. Everything a layout or a caller can get wrong comes back as a Status.
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+#define AUTOLAYOUT_FAIL(exception) throw exception
+#else
+#define AUTOLAYOUT_FAIL(exception) std::abort()
+#endif
+
+namespace autolayout
+{
+    enum Status
+    {
+        STATUS_OK = 0,
+        STATUS_DUPLICATE_CONSTRAINT,        // added already
+        STATUS_UNKNOWN_CONSTRAINT,          // not added, or removed already
+        STATUS_UNSATISFIABLE_CONSTRAINT,    // a required constraint conflicts with the required ones there are
+        STATUS_INVALID_ARGUMENT,            // a malformed definition, or names that don't go together
+        STATUS_INVALID_STATE,               // not allowed at this point (e.g. inside a batch)
+        STATUS_OUT_OF_RANGE,                // no such subview or variant
+        STATUS__COUNT
+    };
+
+    static const char* status_str(Status status)
+    {
+        switch(status)
+        {
+            case STATUS_OK: return "ok";
+            case STATUS_DUPLICATE_CONSTRAINT: return "duplicate constraint";
+            case STATUS_UNKNOWN_CONSTRAINT: return "unknown constraint";
+            case STATUS_UNSATISFIABLE_CONSTRAINT: return "unsatisfiable constraint";
+            case STATUS_INVALID_ARGUMENT: return "invalid argument";
+            case STATUS_INVALID_STATE: return "invalid state";
+            case STATUS_OUT_OF_RANGE: return "out of range";
+            default: return "invalid status";
+        }
+    }
+
+    // a value, or why there is none
+    template<typename T>
+    struct Result
+    {
+        Status status = STATUS_OK;
+        T value {};
+
+        bool ok() const { return status == STATUS_OK; }
+    };
+}
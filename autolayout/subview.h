@@ -1,7 +1,8 @@
 #pragma once
 #include <boost/optional/optional.hpp>
 #include <array>
-#include "./kiwi_fwd.h"
+#include "variable.h"
+#include "solver_set.h"
 #include "constraint_def.h"
 
 namespace autolayout
@@ -10,40 +11,53 @@ namespace autolayout
     {
         std::string _name;
         std::string _type;
-        kiwi::Solver* _solver;
-        std::array<boost::optional<kiwi::Variable>, ATTR__COUNT> _attr = {};
+        uint32_t _index = 0;
+        SolverSet* _solver;
+        std::array<boost::optional<Variable>, ATTR__COUNT> _attr = {};
         boost::optional<double> _intrinsicWidth = {};
         boost::optional<double> _intrinsicHeight = {};
+        bool _static = false;                                   // see View(bool staticLayout)
+        boost::optional<Constraint> _intrinsicWidthCn = {};  // static: width == intrinsic width
+        boost::optional<Constraint> _intrinsicHeightCn = {};
+        SubView* _container = nullptr;                          // hierarchical: the cascaded view it's laid out in, if any
+        bool _placed = false;                                   // hierarchical: _container is settled
+        bool* _gridDirty = nullptr;                             // grid cell: the View's dirty flag, raised by intrinsic size changes
+        bool _pinned = false;                                   // grid cell: a constraint names it, so the solver holds its frame
+        uint32_t _unbound = 0;                                  // by attribute: derived ones _recycle() took out of the solver
         friend class View;
 
     public:
-        explicit SubView(kiwi::Solver* solver, std::string name="", std::string type="") : _name(std::move(name)), _type(std::move(type)), _solver(solver)
+        explicit SubView(SolverSet* solver, std::string name="", std::string type="") : _name(std::move(name)), _type(std::move(type)), _solver(solver)
         {
             if(_name.empty())
             {
-                _attr[ATTR_LEFT].emplace();
-                _attr[ATTR_TOP].emplace();
+                _attr[ATTR_LEFT].emplace(_solver->variables().create());
+                _attr[ATTR_TOP].emplace(_solver->variables().create());
 
-                _solver->addConstraint(kiwi::Constraint{ *_attr[ATTR_LEFT] == 0 });
-                _solver->addConstraint(kiwi::Constraint{ *_attr[ATTR_TOP] == 0 });
+                _solver->addConstraint(Constraint{ *_attr[ATTR_LEFT] == 0 });
+                _solver->addConstraint(Constraint{ *_attr[ATTR_TOP] == 0 });
             }
         }
 
         const std::string& name() const { return _name; }
         const std::string& type() const { return _type; }
-        double top() { return _getAttr(ATTR_TOP).value(); }
-        double bottom() { return _getAttr(ATTR_BOTTOM).value(); }
-        double centerX() { return _getAttr(ATTR_CENTERX).value(); }
-        double centerY() { return _getAttr(ATTR_CENTERY).value(); }
-        double left() { return _getAttr(ATTR_LEFT).value(); }
-        double right() { return _getAttr(ATTR_RIGHT).value(); }
-        double width() { return _getAttr(ATTR_WIDTH).value(); }
-        double height() { return _getAttr(ATTR_HEIGHT).value(); }
+        uint32_t index() const { return _index; }
+        double top() { return _solver->value(_getAttr(ATTR_TOP)) + _offset(ATTR_TOP); }
+        double bottom() { return _solver->value(_getAttr(ATTR_BOTTOM)) + _offset(ATTR_BOTTOM); }
+        double centerX() { return _solver->value(_getAttr(ATTR_CENTERX)) + _offset(ATTR_CENTERX); }
+        double centerY() { return _solver->value(_getAttr(ATTR_CENTERY)) + _offset(ATTR_CENTERY); }
+        double left() { return _solver->value(_getAttr(ATTR_LEFT)) + _offset(ATTR_LEFT); }
+        double right() { return _solver->value(_getAttr(ATTR_RIGHT)) + _offset(ATTR_RIGHT); }
+        double width() { return _solver->value(_getAttr(ATTR_WIDTH)); }
+        double height() { return _solver->value(_getAttr(ATTR_HEIGHT)); }
+
+        // the attribute's variable, once a constraint names it: its value is View::variables().values()[id]
+        const boost::optional<Variable>& variable(Attribute attr) const { return _attr[attr]; }
 
         boost::optional<double> getValue(Attribute attr)
         {
             if(_attr[attr])
-                return _attr[attr]->value();
+                return _solver->value(*_attr[attr]) + _offset(attr);
             return {};
         }
 
@@ -51,60 +65,152 @@ namespace autolayout
 
         void setIntrinsicWidth(boost::optional<double> value)
         {
+            _setIntrinsic(ATTR_WIDTH, _intrinsicWidth, _intrinsicWidthCn, value);
+        }
+
+        boost::optional<double> intrinsicHeight() { return _intrinsicHeight; }
+
+        void setIntrinsicHeight(boost::optional<double> value)
+        {
+            _setIntrinsic(ATTR_HEIGHT, _intrinsicHeight, _intrinsicHeightCn, value);
+        }
+
+    private:
+        // hierarchical: the solver holds positions relative to the container; this is where it sits
+        double _offset(Attribute attr)
+        {
+            if(!_container)
+                return 0;
+
+            switch(attr)
+            {
+                case ATTR_LEFT:
+                case ATTR_RIGHT:
+                case ATTR_CENTERX:
+                    return _container->left();
+                case ATTR_TOP:
+                case ATTR_BOTTOM:
+                case ATTR_CENTERY:
+                    return _container->top();
+                default:
+                    return 0;
+            }
+        }
+
+        void _setIntrinsic(Attribute attr, boost::optional<double>& current, boost::optional<Constraint>& folded, boost::optional<double> value)
+        {
+            // a grid cell's only sizes auto tracks; the grid sets its frame
+            if(_gridDirty)
+            {
+                *_gridDirty = *_gridDirty || value != current;
+                current = value;
+                return;
+            }
+
+            auto const strength = kiwi::strength::create(_name.empty() ? 999 : 998, 1000, 1000);
+
+            if(_static)
+            {
+                if(value == current)
+                    return;
+
+                auto const outer = _solver->inBatch();
+                if(!outer)
+                    _solver->beginBatch();
+                if(folded)
+                    _solver->removeConstraint(*folded);
+                folded.reset();
+
+                if(value)
+                {
+                    folded = Constraint(_getAttr(attr) == *value, strength);
+                    _solver->addConstraint(*folded);
+                }
+                if(!outer)
+                    _solver->commit();
+
+                current = value;
+                return;
+            }
+
             if(value)
             {
-                auto& attr = _getAttr(ATTR_WIDTH);
-                if(!_intrinsicWidth)
-                    _solver->addEditVariable(attr, kiwi::strength::create(_name.empty() ? 999 : 998, 1000, 1000 ));
-                _intrinsicWidth = value;
-                _solver->suggestValue(attr, *value);
+                auto& var = _getAttr(attr);
+                if(!current)
+                    _solver->addEditVariable(var, strength);
+                current = value;
+                _solver->suggestValue(var, *value);
             }
-            else if(_intrinsicWidth)
+            else if(current)
             {
-                _intrinsicWidth.reset();
-                _solver->removeEditVariable(_getAttr(ATTR_WIDTH));
+                current.reset();
+                _solver->removeEditVariable(_getAttr(attr));
             }
         }
 
-        boost::optional<double> intrinsicHeight() { return _intrinsicHeight; }
-
-        void setIntrinsicHeight(boost::optional<double> value)
+        // Taken up again after View::reset() emptied the solver, as name: the variables stay (zeroed), the derived
+        // ones' constraints (right == left + width...) go back in when they are asked for.
+        void _recycle(std::string name)
         {
-            if(value)
+            _name = std::move(name);
+            _unbound = 0;
+            for(int a=0; a<ATTR__COUNT; a++)
             {
-                auto& attr = _getAttr(ATTR_HEIGHT);
-                if(!_intrinsicHeight)
-                    _solver->addEditVariable(attr, kiwi::strength::create(_name.empty() ? 999 : 998, 1000, 1000 ));
-                _intrinsicHeight = value;
-                _solver->suggestValue(attr, *value);
+                if(!_attr[a])
+                    continue;
+                _solver->setValue(*_attr[a], 0);
+                if(a != ATTR_LEFT && a != ATTR_TOP && a != ATTR_WIDTH && a != ATTR_HEIGHT)
+                    _unbound |= 1u << a;
             }
-            else if(_intrinsicHeight)
+            _intrinsicWidth = _intrinsicHeight = {};
+            _intrinsicWidthCn = _intrinsicHeightCn = {};
+            _container = nullptr;
+            _placed = false;
+            _gridDirty = nullptr;
+            _pinned = false;
+
+            if(_name.empty())
             {
-                _intrinsicHeight.reset();
-                _solver->removeEditVariable(_getAttr(ATTR_HEIGHT));
+                _solver->addConstraint(Constraint{ *_attr[ATTR_LEFT] == 0 });
+                _solver->addConstraint(Constraint{ *_attr[ATTR_TOP] == 0 });
             }
         }
 
-    private:
-        const kiwi::Variable& _getAttr(Attribute attr)
+        // its variables' slots back to the table, for a subview no constraint mentions any more
+        void _releaseVariables()
         {
-            if(_attr[attr])
+            for(auto& attr : _attr)
+            {
+                if(attr)
+                    _solver->variables().release(*attr);
+                attr.reset();
+            }
+        }
+
+        const Variable& _getAttr(Attribute attr)
+        {
+            if(_attr[attr] && !(_unbound & (1u << attr)))
                 return *_attr[attr];
-            _attr[attr].emplace();
+            if(!_attr[attr])
+                _attr[attr].emplace(_solver->variables().create());
+            _unbound &= ~(1u << attr);
 
             switch(attr)
             {
                 case ATTR_RIGHT:
-                    _solver->addConstraint(kiwi::Constraint( *_attr[attr] == (_getAttr(ATTR_LEFT) + _getAttr(ATTR_WIDTH))));
+                    _solver->addConstraint(Constraint( *_attr[attr] == (_getAttr(ATTR_LEFT) + _getAttr(ATTR_WIDTH))));
                     break;
                 case ATTR_BOTTOM:
-                    _solver->addConstraint(kiwi::Constraint( *_attr[attr] == (_getAttr(ATTR_TOP) + _getAttr(ATTR_HEIGHT)) ));
+                    _solver->addConstraint(Constraint( *_attr[attr] == (_getAttr(ATTR_TOP) + _getAttr(ATTR_HEIGHT)) ));
                     break;
                 case ATTR_CENTERX:
-                    _solver->addConstraint(kiwi::Constraint( *_attr[attr] == (_getAttr(ATTR_LEFT) + (_getAttr(ATTR_WIDTH) / 2)) ));
+                    _solver->addConstraint(Constraint( *_attr[attr] == (_getAttr(ATTR_LEFT) + (_getAttr(ATTR_WIDTH) / 2)) ));
                     break;
                 case ATTR_CENTERY:
-                    _solver->addConstraint(kiwi::Constraint( *_attr[attr] == (_getAttr(ATTR_TOP) + (_getAttr(ATTR_HEIGHT) / 2)) ));
+                    _solver->addConstraint(Constraint( *_attr[attr] == (_getAttr(ATTR_TOP) + (_getAttr(ATTR_HEIGHT) / 2)) ));
+                    break;
+                case ATTR_CONST:
+                    _solver->addConstraint(Constraint( *_attr[attr] == 0 ));
                     break;
                 default:break;
             }
@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "./kiwi_fwd.h"
+
+namespace autolayout
+{
+    // A variable is an index into the VariableTable it came from (SolverSet::variables()): its value sits in the
+    // table's contiguous array, where updateVariables writes it. Copying one copies an integer.
+    struct Variable
+    {
+        uint32_t id = UINT32_MAX;
+
+        friend bool operator<(Variable a, Variable b) { return a.id < b.id; }
+    };
+
+    // The values of one solver set's variables, by Variable::id. Creating a variable takes a released slot or
+    // appends one: no allocation of its own.
+    class VariableTable
+    {
+    public:
+        Variable create()
+        {
+            if(_free.empty())
+            {
+                _values.push_back(0.0);
+                return Variable{ (uint32_t)_values.size() - 1 };
+            }
+
+            auto const id = _free.back();
+            _free.pop_back();
+            _values[id] = 0.0;
+            return Variable{ id };
+        }
+
+        // its slot goes to a later create(); no constraint may mention it any more
+        void release(Variable variable) { _free.push_back(variable.id); }
+
+        double value(Variable variable) const { return _values[variable.id]; }
+        void setValue(Variable variable, double value) { _values[variable.id] = value; }
+
+        // by id, released slots included
+        const double* values() const { return _values.data(); }
+        size_t size() const { return _values.size(); }
+        size_t live() const { return _values.size() - _free.size(); }
+
+    private:
+        std::vector<double> _values = {};
+        std::vector<uint32_t> _free = {};
+    };
+
+    // kiwi's value types over Variable, with the same accessors
+    class Term
+    {
+    public:
+        Term(Variable variable, double coefficient = 1.0) : _variable(variable), _coefficient(coefficient) {}
+
+        Variable variable() const { return _variable; }
+        double coefficient() const { return _coefficient; }
+
+    private:
+        Variable _variable;
+        double _coefficient;
+    };
+
+    class Expression
+    {
+    public:
+        Expression(double constant = 0.0) : _constant(constant) {}
+        Expression(Variable variable) : _terms(1, Term(variable)) {}
+        Expression(const Term& term, double constant = 0.0) : _terms(1, term), _constant(constant) {}
+        Expression(std::vector<Term> terms, double constant = 0.0) : _terms(std::move(terms)), _constant(constant) {}
+
+        const std::vector<Term>& terms() const { return _terms; }
+        double constant() const { return _constant; }
+
+    private:
+        std::vector<Term> _terms = {};
+        double _constant = 0.0;
+    };
+
+    enum RelationalOperator { OP_LE, OP_GE, OP_EQ };
+
+    // expression op 0, shared: copies are the same constraint (the solver's maps key by identity, as kiwi's do).
+    // A variable's terms are summed into one, in variable order.
+    class Constraint
+    {
+    public:
+        Constraint() = default;
+
+        Constraint(const Expression& expression, RelationalOperator op, double strength = kiwi::strength::required)
+            : _data(std::make_shared<Data>(Data{ _reduce(expression), kiwi::strength::clip(strength), op })) {}
+
+        Constraint(const Constraint& other, double strength)
+            : _data(std::make_shared<Data>(Data{ other.expression(), kiwi::strength::clip(strength), other.op() })) {}
+
+        const Expression& expression() const { return _data->expression; }
+        RelationalOperator op() const { return _data->op; }
+        double strength() const { return _data->strength; }
+
+        bool operator!() const { return !_data; }
+
+        friend bool operator<(const Constraint& a, const Constraint& b) { return a._data < b._data; }
+
+    private:
+        struct Data
+        {
+            Expression expression;
+            double strength;
+            RelationalOperator op;
+        };
+
+        std::shared_ptr<const Data> _data = {};
+
+        static Expression _reduce(const Expression& expression)
+        {
+            auto terms = expression.terms();
+            std::sort(terms.begin(), terms.end(), [](const Term& a, const Term& b){ return a.variable() < b.variable(); });
+
+            auto out = size_t{0};
+            for(size_t i=0; i<terms.size(); i++)
+            {
+                if(out && terms[out - 1].variable().id == terms[i].variable().id)
+                    terms[out - 1] = Term(terms[i].variable(), terms[out - 1].coefficient() + terms[i].coefficient());
+                else
+                    terms[out++] = terms[i];
+            }
+            terms.resize(out, Term(Variable{}));
+            return Expression(std::move(terms), expression.constant());
+        }
+    };
+
+    inline Expression operator*(const Expression& expression, double coefficient)
+    {
+        auto terms = expression.terms();
+        for(auto& term : terms)
+            term = Term(term.variable(), term.coefficient() * coefficient);
+        return Expression(std::move(terms), expression.constant() * coefficient);
+    }
+
+    inline Expression operator*(double coefficient, const Expression& expression) { return expression * coefficient; }
+    inline Expression operator/(const Expression& expression, double denominator) { return expression * (1.0 / denominator); }
+    inline Expression operator-(const Expression& expression) { return expression * -1.0; }
+
+    inline Expression operator+(const Expression& first, const Expression& second)
+    {
+        auto terms = first.terms();
+        terms.insert(terms.end(), second.terms().begin(), second.terms().end());
+        return Expression(std::move(terms), first.constant() + second.constant());
+    }
+
+    inline Expression operator-(const Expression& first, const Expression& second) { return first + -second; }
+
+    inline Constraint operator==(const Expression& first, const Expression& second) { return Constraint(first - second, OP_EQ); }
+    inline Constraint operator<=(const Expression& first, const Expression& second) { return Constraint(first - second, OP_LE); }
+    inline Constraint operator>=(const Expression& first, const Expression& second) { return Constraint(first - second, OP_GE); }
+}
@@ -2,125 +2,927 @@
 #include <boost/optional/optional.hpp>
 #include <boost/variant/variant.hpp>
 #include <boost/variant/get.hpp>
+#include <algorithm>
 #include <array>
-#include "./kiwi_fwd.h"
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include "variable.h"
+#include "arena.h"
+#include "solver_set.h"
 #include <unordered_map>
 #include "constraint_def.h"
+#include "compiled_layout.h"
+#include "grid_def.h"
+#include "layout_cache.h"
+#include "status.h"
 #include "subview.h"
 
 namespace autolayout
 {
-    enum SpacingType { SPACE_TOP, SPACE_RIGHT, SPACE_BOTTOM, SPACE_LEFT, SPACE_HORIZ, SPACE_VERT, SPACE__COUNT };
     using Spacing = std::array<double, SPACE__COUNT>;
 
+    // static mode: a constraint with the spacing value folded into its constant, and how to re-emit it
+    struct FoldedConstraint
+    {
+        Variable left;
+        Relation relation;
+        boost::optional<Variable> right;  // none: the spacing itself
+        double multiplier;
+        boost::optional<double> constant;
+        SpacingType spacing;
+        double strength;
+        Constraint current;               // as last emitted
+    };
+
     class ViewConstraint
     {
-        kiwi::Constraint _con;
-        explicit ViewConstraint(kiwi::Constraint con) : _con(con){}
+        Constraint _con;
+        Status _status;
+        std::shared_ptr<FoldedConstraint> _folded;    // static mode: kept here too, for adding it back after removal
+        explicit ViewConstraint(Constraint con, Status status = STATUS_OK, std::shared_ptr<FoldedConstraint> folded = {})
+            : _con(con), _status(status), _folded(std::move(folded)) {}
         friend class View;
+
+    public:
+        // none, failed with status: for a caller that can't make one (e.g. given a stale handle)
+        explicit ViewConstraint(Status status) : _con(), _status(status) {}
+
+        // whether adding it went through; a failed one is in the solver only if it was already
+        Status status() const { return _status; }
     };
 
+    struct VariantStats
+    {
+        uint64_t switches = 0;
+        uint64_t restored = 0;      // switches served from the variant's last solved values
+        uint64_t applied = 0;       // switches that swapped constraints in the solver
+        uint64_t failed = 0;        // ... that the solver refused, going back to the applied variant
+    };
+
+    enum StepResult { STEP_DONE, STEP_MORE };
+
     class View
     {
-        kiwi::Solver* _solver;
+        std::unique_ptr<Arena> _arena = {};         // first: what the rest allocated from it goes back before it does
+        SolverSet* _solver;
         std::unordered_map<std::string, SubView*> _subViews = {};
+        std::vector<SubView*> _subViewList = {};    // by SubView::index()
+        std::unordered_map<std::string, SubView*> _pool = {};      // reset() keeps subviews here for the next layout (see _addSubView)
+        std::vector<double> _frames = {};
+        std::vector<float> _frames32 = {};
+        std::vector<double> _sweepFrames = {};
+        double _changeEpsilon = -1;                 // < 0: not tracking
+        std::vector<double> _lastFrames = {};       // as of the previous update(), for change tracking
+        std::vector<uint32_t> _changed = {};
+        bool _dirty = true;                         // subviews created since the last update()
+        uint64_t _skippedUpdates = 0;
+        LayoutCache _cache{};                       // off while maxBytes() is 0
+        std::vector<double> _cacheKey = {};
+        std::vector<double> _currentKey = {};       // inputs the variables currently hold the result for
+        bool _cacheRestored = false;                // variables hold cached or variant values the solver didn't write
         SubView* _parentSubView;
+        boost::optional<Variable> _verticalConst = {};   // ^.const for vertical attributes (see _constFor)
         Spacing _spacing = {};
-        mutable std::array<boost::optional<kiwi::Variable>, SPACE__COUNT> _spacingVars = {};
-        mutable std::array<boost::optional<kiwi::Expression>, SPACE__COUNT> _spacingExpr = {};
+        mutable std::array<boost::optional<Variable>, SPACE__COUNT> _spacingVars = {};
+        mutable std::array<boost::optional<Expression>, SPACE__COUNT> _spacingExpr = {};
+        mutable std::array<boost::optional<std::pair<Variable, Expression>>, SPACE__COUNT> _spacingPool = {};   // _spacingVars/Expr as of the last reset()
+        int _batchDepth = 0;
+        std::vector<std::pair<bool, Constraint>> _batchJournal = {}; // (added?, constraint), for rollback
+        bool _static = false;
+        bool _hierarchical = false;
+
+        // hierarchical mode: a cascaded container as ^ for its children, with variables of its own,
+        // so the constraints inside share none with the enclosing ones and solve apart from them
+        struct Scope
+        {
+            SubView* container;
+            std::unique_ptr<SubView> root;              // left/top 0; width/height follow the container's (_updateScopes)
+            std::array<boost::optional<Variable>, SPACE__COUNT> spacingVars = {};
+            std::array<boost::optional<Expression>, SPACE__COUNT> spacingExpr = {};
+            uint32_t depth = 0;                         // containers around it, as of the last _orderScopes
+        };
+        std::vector<std::unique_ptr<Scope>> _scopes = {};   // outermost first while _scopesOrdered
+        bool _scopesOrdered = true;
+        std::unordered_map<const SubView*, Scope*> _scopeByContainer = {};
+
+        // a grid as addGrid resolved it (see GridDef)
+        struct Grid
+        {
+            struct Cell
+            {
+                SubView* view;
+                uint32_t column, row, columnEnd, rowEnd;    // spans [column, columnEnd) x [row, rowEnd)
+            };
+
+            SubView* view;
+            std::vector<Track> columns;                 // one per column, missing ones filled in
+            std::vector<Track> rows;
+            std::vector<Cell> cells = {};
+            std::vector<double> columnOffsets = {};     // track starts and the end, as of the last layout
+            std::vector<double> rowOffsets = {};
+        };
+        std::vector<Grid> _grids = {};
+
+        // static mode, by the constraint handed out as ViewConstraint: the ones in the solver, removed in the open
+        // batch, or a variant's
+        std::map<Constraint, std::shared_ptr<FoldedConstraint>> _folded = {};
+
+        // a named constraint group (see addVariant) and the values it last solved to
+        struct Variant
+        {
+            std::vector<Constraint> constraints;  // handles, as ViewConstraint
+            std::vector<double> key = {};               // inputs the values were solved for (_makeCacheKey)
+            std::vector<double> values = {};            // as _snapshot()
+        };
+        std::map<std::string, Variant> _variants = {};
+        std::string _variant = {};                  // active: what update() solves for
+        std::string _applied = {};                  // whose constraints the solver holds
+        uint64_t _constraintEpoch = 0;              // bumped by constraint changes outside variants
+        VariantStats _variantStats = {};
+
+        // cooperative loading (see queueConstraints)
+        std::vector<ConstraintDef> _queue = {};
+        size_t _queued = 0;                         // how many of _queue are in the solver
+        bool _loading = false;                      // the solver's batch is step()'s, its optimization still due
+        double _stepRate = 0;                       // constraints built and added per microsecond, as last measured
 
     public:
-        View() : _solver(new kiwi::Solver()), _parentSubView{new SubView(_solver)}
+        View() : View(false) {}
+
+        // A static view folds spacing values and intrinsic/root sizes into constraint constants instead of
+        // keeping edit variables for them. Changing one re-emits only the constraints that use it,
+        // which costs more than a suggestion; meant for layouts whose values are set once.
+        explicit View(bool staticLayout) : _solver(new SolverSet()), _parentSubView{new SubView(_solver)}, _static(staticLayout)
         {
+            _parentSubView->_static = staticLayout;
             _subViews.reserve(16);
             setSpacing(8);
         }
 
+        bool isStatic() const { return _static; }
+
+        // Hierarchical mode: each cascaded container ([g:[a][b]]) lays its children out in a coordinate space of
+        // its own, solved apart from the rest. update() solves the outer level first, then hands each container's
+        // size down, so only containers whose size or contents changed re-solve. Children don't size their
+        // container here. Set before adding constraints (STATUS_INVALID_STATE after).
+        Status setHierarchical(bool on)
+        {
+            if(on != _hierarchical && !_subViewList.empty())
+                return STATUS_INVALID_STATE;
+            _hierarchical = on;
+            return STATUS_OK;
+        }
+
+        bool isHierarchical() const { return _hierarchical; }
+
+        // Arena mode: the solver's rows and maps and the subviews come from chunks the View owns (see Arena) instead
+        // of one global heap allocation each; reset() recycles them and destroying the View frees them at once.
+        // Set while the view is empty (STATUS_INVALID_STATE after adding constraints or setting its size, or inside
+        // a batch or beginSuggest()).
+        Status setArena(bool on)
+        {
+            if(on == (_arena != nullptr))
+                return STATUS_OK;
+            if(!_subViewList.empty() || _parentSubView->_intrinsicWidth || _parentSubView->_intrinsicHeight)
+                return STATUS_INVALID_STATE;
+            if(_batchDepth || _solver->inBatch() || _solver->suggestDepth() > (_cache.maxBytes() ? 1 : 0))
+                return STATUS_INVALID_STATE;
+
+            _drainPool();
+            _arena = on ? std::make_unique<Arena>() : nullptr;
+            _solver->setArena(_arena.get());
+            if(_cache.maxBytes())
+                _solver->beginSuggest();
+            return STATUS_OK;
+        }
+
+        bool hasArena() const { return _arena != nullptr; }
+        Arena::Stats arenaStats() const { return _arena ? _arena->stats() : Arena::Stats{}; }
+
+        // After many constraints were added and removed, rebuilds the solver's tableaus and maps at the size of
+        // what is left, with the same solution; returns the bytes reclaimed. Removals already do it for a component
+        // that got wasteful enough (setAutoCompact), so this is for a view about to sit idle.
+        size_t compact()
+        {
+            auto reclaimed = _solver->compact();
+            auto const shrink = [&](auto& v)
+            {
+                auto const before = v.capacity();
+                v.shrink_to_fit();
+                reclaimed += (before - v.capacity()) * sizeof(v[0]);
+            };
+            shrink(_queue);
+            shrink(_batchJournal);
+            return reclaimed;
+        }
+
+        // removals compact a component once its symbol slots outnumber what its constraints can use factor times
+        // (4 by default); 0 leaves it to compact()
+        void setAutoCompact(double factor) { _solver->setAutoCompact(factor); }
+        size_t autoCompacted() const { return _solver->autoCompacted(); }
+
+        // an estimate of the solver's memory: what compact() works on
+        size_t memoryBytes() const { return _solver->memoryBytes(); }
+
         void setSize(double width, double height)
         {
+            _solver->beginSuggest();
             _parentSubView->setIntrinsicWidth(width);
             _parentSubView->setIntrinsicHeight(height);
+            _solver->endSuggest();
         }
 
         std::unordered_map<std::string, SubView*>& getSubViews() { return _subViews; }
 
+        // subviews by stable index: creation order, until reset()
+        size_t subViewCount() const { return _subViewList.size(); }
+        SubView* getSubView(size_t index) const { return index < _subViewList.size() ? _subViewList[index] : nullptr; }
+
+        int indexOf(const std::string& name) const
+        {
+            auto it = _subViews.find(name);
+            return it != _subViews.end() ? (int)it->second->index() : -1;
+        }
+
+        // every variable's value by Variable::id (see SubView::variable), as the last update() left them
+        const VariableTable& variables() const { return _solver->variables(); }
+
+        // [left, top, width, height] per subview in index order: 4 * subViewCount() values
+        template<typename T>
+        void writeFrames(T* out) const
+        {
+            for(auto* sv : _subViewList)
+            {
+                *out++ = (T)sv->left();
+                *out++ = (T)sv->top();
+                *out++ = (T)sv->width();
+                *out++ = (T)sv->height();
+            }
+        }
+
+        // writeFrames into a buffer the View owns; valid until the next call
+        const double* frames()
+        {
+            _frames.resize(_subViewList.size() * 4);
+            writeFrames(_frames.data());
+            return _frames.data();
+        }
+
+        const float* frames32()
+        {
+            _frames32.resize(_subViewList.size() * 4);
+            writeFrames(_frames32.data());
+            return _frames32.data();
+        }
+
+        // Solves for count [width, height] pairs in order, each a dual simplex step from the previous basis, and
+        // writes each one's frames (as writeFrames) to out: count * 4 * subViewCount() values.
+        // The view gets its own size back afterwards; changed() then compares with the last update(), not the sizes swept.
+        template<typename T>
+        void sweep(const double* sizes, size_t count, T* out)
+        {
+            auto const width = _parentSubView->_intrinsicWidth, height = _parentSubView->_intrinsicHeight;
+            auto const stride = _subViewList.size() * 4;
+
+            for(size_t i=0; i<count; i++)
+            {
+                setSize(sizes[i * 2], sizes[i * 2 + 1]);
+                _solve();
+                writeFrames(out + i * stride);
+            }
+
+            _solver->beginSuggest();
+            _parentSubView->setIntrinsicWidth(width);
+            _parentSubView->setIntrinsicHeight(height);
+            _solver->endSuggest();
+            _settle();
+        }
+
+        // sweep into a buffer the View owns; valid until the next call
+        const double* sweep(const double* sizes, size_t count)
+        {
+            _sweepFrames.resize(count * _subViewList.size() * 4);
+            sweep(sizes, count, _sweepFrames.data());
+            return _sweepFrames.data();
+        }
+
+        // Lays out count rows (e.g. list cells) that differ only in some intrinsic sizes. params holds paramCount
+        // [index, axis] pairs (axis 0: width, 1: height) naming distinct subviews' intrinsic sizes; values holds
+        // paramCount values per row. Writes each row's frames (as writeFrames) to out.
+        // One solve gives the optimal basis, and rows that keep it feasible are only evaluated from it;
+        // the others are solved (returns how many, the first row's included), and the last few bases solved are
+        // tried from then on. The subviews get their own intrinsic sizes back afterwards, and changed() compares
+        // with the last update(). STATUS_OUT_OF_RANGE for an unknown index, STATUS_INVALID_ARGUMENT for a pair
+        // given twice.
+        template<typename T>
+        Result<size_t> solveRows(const uint32_t* params, size_t paramCount, const double* values, size_t count, T* out)
+        {
+            auto subViews = std::vector<SubView*>(paramCount);
+            auto original = std::vector<boost::optional<double>>(paramCount);
+            auto edits = std::vector<Variable>(paramCount);
+            for(size_t p=0; p<paramCount; p++)
+            {
+                if(params[p * 2] >= _subViewList.size())
+                    return { STATUS_OUT_OF_RANGE };
+                for(size_t q=0; q<p; q++)
+                {
+                    if(params[q * 2] == params[p * 2] && !params[q * 2 + 1] == !params[p * 2 + 1])
+                        return { STATUS_INVALID_ARGUMENT };
+                }
+
+                subViews[p] = _subViewList[params[p * 2]];
+                original[p] = params[p * 2 + 1] ? subViews[p]->_intrinsicHeight : subViews[p]->_intrinsicWidth;
+            }
+
+            auto const apply = [&](const double* row)
+            {
+                _solver->beginSuggest();
+                for(size_t p=0; p<paramCount; p++)
+                {
+                    if(params[p * 2 + 1])
+                        subViews[p]->setIntrinsicHeight(row ? boost::optional<double>(row[p]) : original[p]);
+                    else
+                        subViews[p]->setIntrinsicWidth(row ? boost::optional<double>(row[p]) : original[p]);
+                }
+                _solver->endSuggest();
+                if(row)
+                    _solve();
+                else
+                    _settle();
+            };
+
+            auto outputs = std::vector<Variable>{};
+            outputs.reserve(_subViewList.size() * 4);
+            for(auto* sv : _subViewList)
+            {
+                for(auto attr : { ATTR_LEFT, ATTR_TOP, ATTR_WIDTH, ATTR_HEIGHT })
+                    outputs.push_back(sv->_getAttr(attr));
+            }
+
+            auto const stride = _subViewList.size() * 4;
+            auto solved = size_t{0};
+            auto rowFrames = std::vector<double>(stride);
+            auto bases = std::vector<SolverSet::Parametric>{};     // most recently useful first
+            for(size_t i=0; i<count; i++, values += paramCount, out += stride)
+            {
+                auto it = std::find_if(bases.begin(), bases.end(), [&](auto const& basis){ return basis.evaluate(values, rowFrames.data()); });
+                if(it != bases.end())
+                {
+                    std::rotate(bases.begin(), it, it + 1);
+                    std::copy(rowFrames.begin(), rowFrames.end(), out);
+                    continue;
+                }
+
+                apply(values);
+                writeFrames(out);
+                solved++;
+
+                // a static view has no edit variables to parametrize by, and a basis doesn't cover grid layouts
+                if(!_static && _scopes.empty() && _grids.empty())
+                {
+                    for(size_t p=0; p<paramCount; p++)
+                        edits[p] = subViews[p]->_getAttr(params[p * 2 + 1] ? ATTR_HEIGHT : ATTR_WIDTH);
+                    if(bases.size() == 4)
+                        bases.pop_back();
+                    bases.insert(bases.begin(), _solver->parametric(edits, outputs));
+                }
+            }
+
+            if(count)
+                apply(nullptr);
+            return { STATUS_OK, solved };
+        }
+
+        // count records of [index, width, height]; NaN clears that intrinsic size. All are solved together.
+        // returns how many records named an existing subview (the others are skipped)
+        size_t setIntrinsicSizes(const double* records, size_t count)
+        {
+            auto applied = size_t{0};
+            _solver->beginSuggest();
+            for(size_t i=0; i<count; i++, records += 3)
+            {
+                auto const index = records[0];
+                if(!(index >= 0 && index < _subViewList.size()))
+                    continue;
+
+                auto* sv = _subViewList[(size_t)index];
+                sv->setIntrinsicWidth(std::isnan(records[1]) ? boost::none : boost::optional<double>(records[1]));
+                sv->setIntrinsicHeight(std::isnan(records[2]) ? boost::none : boost::optional<double>(records[2]));
+                applied++;
+            }
+            _solver->endSuggest();
+            return applied;
+        }
+
         void setSpacing(Spacing spacing)
         {
-            if(_spacing != spacing)
+            _dirty = _dirty || (_spacing != spacing && !_grids.empty());
+            if(_spacing != spacing && _static)
+            {
+                auto const old = _spacing;
+                _spacing = spacing;
+
+                auto const outer = _solver->inBatch();
+                if(!outer)
+                    _solver->beginBatch();
+                for(int i=0; i<SPACE__COUNT; i++)
+                {
+                    if(old[i] != spacing[i])
+                        _refold((SpacingType)i);
+                }
+                if(!outer)
+                    _solver->commit();
+            }
+            else if(_spacing != spacing)
             {
                 _spacing = spacing;
+                _solver->beginSuggest();
                 for(int i=0; i<SPACE__COUNT; i++)
                 {
                     if(_spacingVars[i])
                         _solver->suggestValue(*_spacingVars[i], spacing[i]);
+                    for(auto& scope : _scopes)
+                    {
+                        if(scope->spacingVars[i])
+                            _solver->suggestValue(*scope->spacingVars[i], spacing[i]);
+                    }
                 }
+                _solver->endSuggest();
             }
         }
 
         void setSpacing(double value){ setSpacing({value, value, value, value, value, value}); }
 
+        // Constraints that can't be added come back with a failed status() (see Status): a malformed def, a
+        // duplicate, or a required one the required ones there are rule out. In a batch that last one rolls it back.
         ViewConstraint addConstraint(const ConstraintDef& con)
         {
-			auto left = _getSubView(con.view1)->_getAttr(con.attr1);
-			auto right = boost::optional<kiwi::Expression>{};
-			auto strength = kiwi::strength::create(0, con.priority.value_or(500), 1000);
+            auto cn = Constraint{};
+            auto status = _makeConstraint(con, cn);
+            if(!status)
+                status = _addConstraint(cn);
+            if(status)
+                _unfold({ cn });
+            return _handle(cn, status);
+        }
+
+        // bulk load: builds every constraint first, then hands the whole set to the solver in one pass.
+        // On failure out is left as it was; the constraints before the failing one may be in the solver.
+        Status addConstraints(const std::vector<ConstraintDef>& defs, std::vector<ViewConstraint>* out = nullptr)
+        {
+            return _addConstraints(defs.data(), defs.data() + defs.size(), out);
+        }
 
-			if(con.view2 == "-")
-				right =  -_getSpacing(con);
-			else
-				right = kiwi::Term{ _getSubView(con.view2)->_getAttr(con.attr2) };
+        // Cooperative loading: defs wait here, after any queued before, for step() to add and solve them a time
+        // budget at a time, so a large layout can be spread over several frames instead of blocking in
+        // addConstraints/update.
+        void queueConstraints(const std::vector<ConstraintDef>& defs)
+        {
+            _queue.insert(_queue.end(), defs.begin(), defs.end());
+        }
 
-			if(auto* m = con.multiplier.get_ptr(); m && *m != 1)
-				right = *right * *m;
+        // Adds queued constraints in bulk-loaded chunks sized to fit, then optimizes a bounded number of pivots at a
+        // time, until about budgetMicros passed (at least one chunk or pivot round per call, so it always gets on).
+        // They go straight to the tableau: a closed form (see ClosedForm) is only ever handed over whole.
+        // Between calls the tableau is feasible and everything else works as usual; update() meanwhile shows the
+        // constraints added so far at a feasible but not yet optimal point. STEP_DONE once all of them are solved
+        // and update() ran. A chunk that fails to add returns its status; the next call goes on after it.
+        Result<StepResult> step(double budgetMicros)
+        {
+            if(_batchDepth)
+                return { STATUS_INVALID_STATE };
 
-            if (auto* constant = con.constant.get_ptr())
-				right = *right + *constant;
-            else
-				right = *right + _getSpacing(con);
+            auto const start = std::chrono::steady_clock::now();
+            auto const elapsed = [&]{ return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count(); };
 
-			auto cn = boost::optional<kiwi::Constraint>{};
-            switch(con.relation)
-			{
-				case REL_EQU:cn = kiwi::Constraint(left == *right, strength);break;
-				case REL_GEQ:cn = kiwi::Constraint(left >= *right, strength);break;
-				case REL_LEQ:cn = kiwi::Constraint(left <= *right, strength);break;
-			}
+            if(!_loading && _queued < _queue.size())
+            {
+                _solver->setClosedForm(false);
+                _solver->beginBatch();
+                _loading = true;
+            }
+
+            while(_queued < _queue.size())
+            {
+                auto const before = elapsed();
+                auto count = _stepRate > 0 ? (size_t)std::max(1.0, (budgetMicros - before) * _stepRate) : size_t{64};
+                count = std::min(count, _queue.size() - _queued);
+                auto const status = _addConstraints(_queue.data() + _queued, _queue.data() + _queued + count, nullptr);
+                _queued += count;
+                _stepRate = (double)count / std::max(elapsed() - before, 1.0);
+
+                if(status)
+                    return { status, STEP_MORE };
+                if(elapsed() >= budgetMicros && _queued < _queue.size())
+                    return { STATUS_OK, STEP_MORE };
+            }
+            _queue.clear();
+            _queued = 0;
+
+            while(_loading)
+            {
+                auto pivots = size_t{64};
+                _loading = !_solver->commitSome(pivots);
+                if(_loading && elapsed() >= budgetMicros)
+                    return { STATUS_OK, STEP_MORE };
+            }
+            _solver->setClosedForm(true);
+
+            update();
+            return { STATUS_OK, STEP_DONE };
+        }
+
+        // constraints queued or added by step() still waiting to be solved
+        bool loading() const { return _loading || _queued < _queue.size(); }
+
+        // applies a precompiled layout; names were resolved at compile time, so this only indexes slots.
+        // Compiled layouts have no containers: STATUS_INVALID_STATE in hierarchical mode (use addConstraints).
+        Status instantiate(const CompiledLayout& layout, std::vector<ViewConstraint>* out = nullptr)
+        {
+            if(_hierarchical)
+                return STATUS_INVALID_STATE;
+            for(auto const& item : layout.items())
+            {
+                if(item.spacing == SPACE__COUNT)
+                    return STATUS_INVALID_ARGUMENT;
+            }
+
+            auto const& slots = layout.slots();
+            auto views = std::vector<SubView*>(slots.size());
+            auto cns = std::vector<Constraint>{};
+            cns.reserve(layout.size());
+
+            auto derived = std::vector<Constraint>{};
+            _collectDerived(derived, [&]
+            {
+                for(size_t i=0; i<slots.size(); i++)
+                {
+                    auto* sv = views[i] = _getSubView(slots[i].name);
+                    for(int attr=0; attr<ATTR__COUNT; attr++)
+                    {
+                        if(slots[i].attrs & (1u << attr))
+                            sv->_getAttr((Attribute)attr);
+                    }
+                }
+                return STATUS_OK;
+            });
+
+            for(auto const& item : layout.items())
+            {
+                auto const& left = *views[item.view1]->_attr[item.attr1];
+                auto const* right = item.view2 == CompiledLayout::SLOT_SPACING ? nullptr : &_getAttr(views[item.view2], item.attr2, item.attr1);
+
+                cns.push_back(_makeConstraint(left, item.relation, right, item.multiplier, item.constant, item.spacing, item.strength));
+            }
+
+            return _addConstraints(std::move(derived), cns, out);
+        }
+
+        // Adds a grid (see GridDef). Its cells are subviews constraints can name, but only the grid sizes and
+        // places them, by track sizing in the grid's solved frame after each solve: none of a cell's attributes
+        // go into the solver until a constraint names the cell. From then its frame is suggested as edits, so
+        // constraints see it without moving it; those are solved for in a second pass.
+        // STATUS_INVALID_ARGUMENT, with nothing added, for a grid without a name or a cell that can't be one.
+        Status addGrid(const GridDef& def)
+        {
+            if(is_super(def.name) || def.name == "-")
+                return STATUS_INVALID_ARGUMENT;
+
+            // bounding box and slot count per name: a span has to fill its box
+            struct Span { uint32_t column, row, columnEnd, rowEnd, slots; };
+            auto order = std::vector<std::string>{};
+            auto spans = std::map<std::string, Span>{};
+            auto columnCount = (uint32_t)def.columns.size();
+            for(uint32_t row=0; row<def.cells.size(); row++)
+            {
+                columnCount = std::max(columnCount, (uint32_t)def.cells[row].size());
+                for(uint32_t column=0; column<def.cells[row].size(); column++)
+                {
+                    auto const& name = def.cells[row][column];
+                    if(name.empty())
+                        continue;
+                    if(is_super(name) || name == def.name)
+                        return STATUS_INVALID_ARGUMENT;
+
+                    auto [it, added] = spans.emplace(name, Span{ column, row, column + 1, row + 1, 0 });
+                    auto& span = it->second;
+                    if(added)
+                        order.push_back(name);
+                    span.column = std::min(span.column, column);
+                    span.row = std::min(span.row, row);
+                    span.columnEnd = std::max(span.columnEnd, column + 1);
+                    span.rowEnd = std::max(span.rowEnd, row + 1);
+                    span.slots++;
+                }
+            }
+            for(auto const& [name, span] : spans)
+            {
+                if(span.slots != (span.columnEnd - span.column) * (span.rowEnd - span.row))
+                    return STATUS_INVALID_ARGUMENT;
+            }
+            for(auto const& name : order)
+            {
+                auto it = _subViews.find(name);
+                if(it != _subViews.end() && it->second->_gridDirty)
+                    return STATUS_INVALID_ARGUMENT;
+            }
+
+            // a grid that is a cell of another isn't pinned by this: the outer one, added first, places it
+            auto const named = _subViews.find(def.name);
+            auto grid = Grid{ named != _subViews.end() ? named->second : _getSubView(def.name), def.columns, def.rows };
+            grid.columns.resize(std::max<size_t>(columnCount, def.columns.size()));
+            grid.rows.resize(std::max(def.cells.size(), def.rows.size()));
+            for(auto attr : { ATTR_LEFT, ATTR_TOP, ATTR_WIDTH, ATTR_HEIGHT })
+                grid.view->_getAttr(attr);
+
+            // hierarchical: a grid nothing placed yet is at the top level; its cells are wherever it is
+            if(_hierarchical && !grid.view->_placed)
+            {
+                grid.view->_placed = true;
+                _scopesOrdered = _scopesOrdered && !_scopeByContainer.count(grid.view);
+            }
+
+            grid.cells.reserve(order.size());
+            for(auto const& name : order)
+            {
+                auto const& span = spans.at(name);
+                auto const existing = _subViews.count(name) > 0;
+                auto* sv = _getSubView(name);
+                if(_hierarchical && sv->_placed && sv->_container != grid.view->_container)
+                    return STATUS_INVALID_ARGUMENT;
+
+                // the grid takes its frame over from the solver; its intrinsic size stays, for auto tracks
+                auto const width = sv->_intrinsicWidth, height = sv->_intrinsicHeight;
+                sv->setIntrinsicWidth(boost::none);
+                sv->setIntrinsicHeight(boost::none);
+                sv->_intrinsicWidth = width;
+                sv->_intrinsicHeight = height;
+                for(int attr=ATTR_LEFT; attr<ATTR__COUNT; attr++)
+                {
+                    if(!sv->_attr[attr])
+                        sv->_attr[attr].emplace(_solver->variables().create());
+                }
+                sv->_gridDirty = &_dirty;
+                sv->_container = grid.view->_container;
+                sv->_placed = sv->_placed || _hierarchical;
+
+                // named before the grid was added: constraints hold it already
+                if(existing)
+                    _pinCell(sv);
+                grid.cells.push_back(Grid::Cell{ sv, span.column, span.row, span.columnEnd, span.rowEnd });
+            }
+
+            _grids.push_back(std::move(grid));
+            _dirty = true;
+            _constraintEpoch++;
+            return STATUS_OK;
+        }
+
+        size_t gridCount() const { return _grids.size(); }
+
+        // Responsive variants: named groups of constraints over the same subviews (e.g. phone/tablet/desktop),
+        // built once here and held out of the solver until setVariant() picks one. Constraints added outside
+        // variants apply to all of them. STATUS_INVALID_ARGUMENT for an empty or duplicate name or a malformed def.
+        Status addVariant(const std::string& name, const std::vector<ConstraintDef>& defs)
+        {
+            if(name.empty() || _variants.count(name))
+                return STATUS_INVALID_ARGUMENT;
+
+            auto variant = Variant{};
+            variant.constraints.resize(defs.size());
+            auto derived = std::vector<Constraint>{};
+            auto const status = _collectDerived(derived, [&]
+            {
+                for(size_t i=0; i<defs.size(); i++)
+                {
+                    if(auto const status = _makeConstraint(defs[i], variant.constraints[i]))
+                        return status;
+                }
+                return STATUS_OK;
+            });
+            _solver->addConstraints(derived);
+            if(status)
+            {
+                _unfold(variant.constraints);
+                return status;
+            }
+            _variants.emplace(name, std::move(variant));
+            return STATUS_OK;
+        }
+
+        // Makes name ("" for none) the active variant. The next update() restores the values it last solved to
+        // if nothing else changed since, and only otherwise swaps the constraints in the solver and solves; if the
+        // solver refuses them, the variant applied before stays active (variantStats().failed).
+        Status setVariant(const std::string& name)
+        {
+            if(name == _variant)
+                return STATUS_OK;
+            if(!name.empty() && !_variants.count(name))
+                return STATUS_OUT_OF_RANGE;
 
-            _solver->addConstraint(*cn);
-            return ViewConstraint(*cn);
+            // keep what the outgoing one solved to for switching back; restored values already are
+            if(!_variant.empty() && _variant == _applied && !dirty())
+            {
+                auto& outgoing = _variants.at(_variant);
+                _makeCacheKey(outgoing.key, (double)_constraintEpoch);
+                outgoing.values = _snapshot();
+            }
+
+            _variant = name;
+            _dirty = true;
+            _variantStats.switches++;
+            return STATUS_OK;
         }
 
+        const std::string& variant() const { return _variant; }
+        const VariantStats& variantStats() const { return _variantStats; }
+
         ViewConstraint addConstraint(const ViewConstraint& con)
         {
-            _solver->addConstraint(con._con);
-            return con;
+            if(!con._con)
+                return ViewConstraint(STATUS_INVALID_ARGUMENT);
+            if(con._folded)
+                _folded.emplace(con._con, con._folded);
+            auto const status = _addConstraint(_refresh(con._con));
+            if(status)
+                _unfold({ con._con });
+            return ViewConstraint(con._con, status, con._folded);
         }
 
-        void removeConstraint(const ViewConstraint& con)
+        Status removeConstraint(const ViewConstraint& con)
         {
-            _solver->removeConstraint(con._con);
+            if(auto const status = _solver->removeConstraint(_current(con._con)))
+                return status;
+            _constraintEpoch++;
+            if(_batchDepth)
+                _batchJournal.emplace_back(false, con._con);
+            else
+                _unfold({ con._con });
+            return STATUS_OK;
         }
 
-        void update() { _solver->updateVariables(); }
+        // Adds and removes up to the matching commit() go into the tableau right away,
+        // but the solver optimizes only once, at commit. Batches nest.
+        void beginBatch()
+        {
+            if(_batchDepth++ == 0 && !_loading)
+                _solver->beginBatch();
+        }
+
+        void commit()
+        {
+            if(_batchDepth == 0 || --_batchDepth > 0)
+                return;
+
+            for(auto const& [added, cn] : _batchJournal)
+            {
+                if(!added)
+                    _unfold({ cn });
+            }
+            _batchJournal.clear();
+            if(!_loading)
+                _solver->commit();
+        }
+
+        bool inBatch() const { return _batchDepth > 0; }
+
+        // Size, spacing and intrinsic size changes up to the matching endSuggest() are solved together,
+        // e.g. measured text sizes for every subview in one pass instead of one per subview. Nests.
+        void beginSuggest() { _solver->beginSuggest(); }
+        void endSuggest() { _solver->endSuggest(); }
+
+        // a no-op (counted in stats()) unless something changed since the previous update()
+        void update()
+        {
+            if(!_solve())
+            {
+                _skippedUpdates++;
+                _changed.clear();
+                return;
+            }
+
+            if(_changeEpsilon >= 0)
+                _collectChanged();
+        }
+
+        // Opt-in memo of update() results keyed by root size, spacing, every intrinsic size and the constraint set,
+        // holding up to maxBytes (least recently used go first; 0 turns it off). Meanwhile suggestions only queue
+        // in the solver, and an update() whose inputs were seen before restores the values without solving.
+        void enableCache(size_t maxBytes)
+        {
+            auto const was = _cache.maxBytes() > 0;
+            _cache.setMaxBytes(maxBytes);
+            if(maxBytes && !was)
+                _solver->beginSuggest();
+            else if(!maxBytes && was)
+            {
+                _cache.clear();
+                _currentKey.clear();
+                if(_cacheRestored)
+                    _solver->invalidateVariables();
+                _cacheRestored = false;
+                _solver->endSuggest();
+            }
+        }
+
+        const LayoutCache::Stats& cacheStats() const { return _cache.stats(); }
+
+        // independent sub-problems the constraints currently form, each with its own tableau
+        size_t componentCount() const { return _solver->componentCount(); }
+
+        // constraints solved by substitution instead of the simplex: those of components that are only
+        // equalities forming chains (see ClosedForm), counting derived attributes' and ^'s own
+        size_t closedFormConstraints() const { return _solver->closedFormConstraints(); }
+
+        bool dirty() const { return _dirty || _solver->dirty(); }
+
+        // suggestions (size, spacing, intrinsic sizes) and update() calls executed vs. skipped as no-ops
+        SolverSet::Stats stats() const
+        {
+            auto stats = _solver->stats();
+            stats.skippedUpdates += _skippedUpdates;
+            return stats;
+        }
+
+        // With tracking on, each update() lists in changed() the indices of subviews whose left/top/width/height
+        // moved by more than epsilon since the previous update() (new subviews count as moved). < 0 turns it off.
+        void trackChanges(double epsilon)
+        {
+            _changeEpsilon = epsilon;
+            _lastFrames.clear();
+            _changed.clear();
+            _dirty = true;
+        }
+
+        const std::vector<uint32_t>& changed() const { return _changed; }
 
         void reset()
         {
-            _parentSubView->_intrinsicHeight = _parentSubView->_intrinsicWidth = {};
+            _batchDepth = 0;
+            _batchJournal.clear();
+            _queue.clear();
+            _queued = 0;
+            _loading = false;
+            _solver->setClosedForm(true);
 
             _solver->reset();
-            for(auto kv : _subViews)
-                delete kv.second;
-            _subViews.clear();
+            // the root's origin pins and derived attributes (right == left + width...) went with the rest
+            _parentSubView->_recycle("");
+            _cache.clear();
+            _currentKey.clear();
+            _cacheRestored = false;
+            if(_cache.maxBytes())
+                _solver->beginSuggest();
+
+            // the last layout's subviews wait in the pool for the next to ask for them again; what the one before left
+            // there unclaimed goes
+            _drainPool();
+            _pool.swap(_subViews);
+            _subViewList.clear();
+            _lastFrames.clear();
+            _changed.clear();
+            _dirty = true;
 
+            for(int i=0; i<SPACE__COUNT; i++)
+            {
+                if(_spacingVars[i])
+                    _spacingPool[i].emplace(*_spacingVars[i], std::move(*_spacingExpr[i]));
+            }
             _spacingVars.fill({});
             _spacingExpr.fill({});
+            for(auto& scope : _scopes)
+            {
+                scope->root->_releaseVariables();
+                for(auto& var : scope->spacingVars)
+                {
+                    if(var)
+                        _solver->variables().release(*var);
+                }
+            }
+            _scopes.clear();
+            _scopeByContainer.clear();
+            _scopesOrdered = true;
+            _grids.clear();
+            if(_verticalConst)
+                _solver->variables().release(*_verticalConst);
+            _verticalConst.reset();
+            _folded.clear();
+            _variants.clear();
+            _variant.clear();
+            _applied.clear();
+            _constraintEpoch++;
         }
 
         ~View()
         {
             for(const auto &kv : _subViews)
-                delete kv.second;
+                arena_delete(_arena.get(), kv.second);
             _subViews.clear();
+            _drainPool();
             delete _solver;
             delete _parentSubView;
         }
@@ -134,67 +936,725 @@ namespace autolayout
             {
                 auto it = _subViews.find(name);
                 if(it != _subViews.end())
+                {
+                    if(it->second->_gridDirty && !it->second->_pinned)
+                        _pinCell(it->second);
                     return it->second;
+                }
 
-                auto* newItem = new SubView(_solver, name);
-                _subViews[name] = newItem;
+                auto* newItem = _addSubView(name);
+                newItem->_index = (uint32_t)_subViewList.size();
+                newItem->_static = _static;
+                _dirty = true;
+                _subViewList.push_back(newItem);
                 return newItem;
             }
         }
 
-        const kiwi::Expression& _getSpacing(const ConstraintDef& con) const
+        // into _subViews: the pooled subview of that name, else any pooled one renamed, else a new one
+        SubView* _addSubView(const std::string& name)
         {
-        	auto sp = SPACE_HORIZ;
-			if(con.view2 == "-")
+            if(_pool.empty())
+                return _subViews[name] = arena_new<SubView>(_arena.get(), _solver, name);
+
+            auto it = _pool.find(name);
+            auto node = _pool.extract(it != _pool.end() ? it : _pool.begin());
+            node.key() = name;
+            node.mapped()->_recycle(name);
+            return _subViews.insert(std::move(node)).position->second;
+        }
+
+        void _drainPool()
+        {
+            for(auto& kv : _pool)
+            {
+                kv.second->_releaseVariables();
+                arena_delete(_arena.get(), kv.second);
+            }
+            _pool.clear();
+        }
+
+        // version: of the constraint set
+        void _makeCacheKey(std::vector<double>& key, double version) const
+        {
+            key.clear();
+            key.push_back(version);
+            key.push_back((double)_subViewList.size());
+            key.insert(key.end(), _spacing.begin(), _spacing.end());
+
+            auto add = [&](const boost::optional<double>& v)
+            {
+                key.push_back(v ? 1 : 0);
+                key.push_back(v.value_or(0));
+            };
+            add(_parentSubView->_intrinsicWidth);
+            add(_parentSubView->_intrinsicHeight);
+            for(auto* sv : _subViewList)
+            {
+                add(sv->_intrinsicWidth);
+                add(sv->_intrinsicHeight);
+            }
+        }
+
+        // every attribute value of the root and the subviews, NaN where the attribute doesn't exist
+        std::vector<double> _snapshot() const
+        {
+            auto values = std::vector<double>{};
+            values.reserve((_subViewList.size() + 1) * ATTR__COUNT);
+
+            auto add = [&](const SubView* sv)
+            {
+                for(auto const& attr : sv->_attr)
+                    values.push_back(attr ? _solver->value(*attr) : std::numeric_limits<double>::quiet_NaN());
+            };
+            add(_parentSubView);
+            for(auto* sv : _subViewList)
+                add(sv);
+            return values;
+        }
+
+        void _restore(const std::vector<double>& values)
+        {
+            auto const* v = values.data();
+            auto set = [&](SubView* sv)
+            {
+                for(auto& attr : sv->_attr)
+                {
+                    if(attr && !std::isnan(*v))
+                        _solver->setValue(*attr, *v);
+                    v++;
+                }
+            };
+            set(_parentSubView);
+            for(auto* sv : _subViewList)
+                set(sv);
+        }
+
+        void _collectChanged()
+        {
+            _changed.clear();
+            auto const known = _lastFrames.size() / 4;
+            _lastFrames.resize(_subViewList.size() * 4);
+
+            for(uint32_t i=0; i<_subViewList.size(); i++)
+            {
+                auto* sv = _subViewList[i];
+                double frame[] = { sv->left(), sv->top(), sv->width(), sv->height() };
+                auto* last = &_lastFrames[i * 4];
+
+                auto moved = i >= known;
+                for(int k=0; k<4 && !moved; k++)
+                    moved = std::abs(frame[k] - last[k]) > _changeEpsilon;
+
+                if(moved)
+                {
+                    std::copy(frame, frame + 4, last);
+                    _changed.push_back(i);
+                }
+            }
+        }
+
+        Status _addConstraint(const Constraint& cn)
+        {
+            _constraintEpoch++;
+            auto const status = _solver->addConstraint(cn);
+            if(!_batchDepth)
+                return status;
+
+            if(status == STATUS_UNSATISFIABLE_CONSTRAINT)
+                _rollback();
+            else if(!status)
+                _batchJournal.emplace_back(true, cn);
+            return status;
+        }
+
+        // Runs build (returning a Status) with the derived attribute constraints it creates held back in derived,
+        // so they go into the same bulk load as the caller's own. If build fails they are added right away.
+        template<typename F>
+        Status _collectDerived(std::vector<Constraint>& derived, F&& build)
+        {
+            if(_batchDepth)
+                return build();
+
+            _solver->collect(&derived);
+            auto const status = build();
+            _solver->collect(nullptr);
+            if(status)
+            {
+                _solver->addConstraints(derived);
+                derived.clear();
+            }
+            return status;
+        }
+
+        // defs in [begin, end) built and bulk loaded together
+        Status _addConstraints(const ConstraintDef* begin, const ConstraintDef* end, std::vector<ViewConstraint>* out)
+        {
+            auto cns = std::vector<Constraint>(end - begin);
+            auto derived = std::vector<Constraint>{};
+            auto status = _collectDerived(derived, [&]
+            {
+                for(auto* def = begin; def != end; def++)
+                {
+                    if(auto const status = _makeConstraint(*def, cns[def - begin]))
+                        return status;
+                }
+                return STATUS_OK;
+            });
+            if(status)
+            {
+                _unfold(cns);
+                return status;
+            }
+
+            status = _addConstraints(std::move(derived), cns, out);
+            if(status)
+                _unfold(cns);
+            return status;
+        }
+
+        Status _addConstraints(std::vector<Constraint> derived, const std::vector<Constraint>& cns, std::vector<ViewConstraint>* out)
+        {
+            _constraintEpoch++;
+            auto status = STATUS_OK;
+            if(_batchDepth)
+            {
+                for(auto const& cn : cns)
+                {
+                    if((status = _addConstraint(cn)))
+                        return status;
+                }
+            }
+            else
+            {
+                // derived ones last: by then the chains made their variables basic, so each solves for its width/height
+                auto all = cns;
+                all.insert(all.end(), derived.begin(), derived.end());
+                if((status = _solver->addConstraints(all)))
+                    return status;
+            }
+
+            if(out)
+            {
+                out->reserve(out->size() + cns.size());
+                for(auto const& cn : cns)
+                    out->emplace_back(_handle(cn));
+            }
+            return STATUS_OK;
+        }
+
+        // undo the batch's constraint changes in reverse and leave batch mode.
+        // subviews, derived attributes and spacing variables created meanwhile stay; they are unconstrained by themselves.
+        void _rollback()
+        {
+            _constraintEpoch++;
+            for(auto it = _batchJournal.rbegin(); it != _batchJournal.rend(); ++it)
+            {
+                if(it->first)
+                {
+                    _solver->removeConstraint(it->second);
+                    _unfold({ it->second });
+                }
+                else
+                    _solver->addConstraint(_current(it->second));
+            }
+
+            _batchJournal.clear();
+            _batchDepth = 0;
+            if(!_loading)
+                _solver->commit();
+        }
+
+        Status _makeConstraint(const ConstraintDef& con, Constraint& out)
+        {
+			auto const spacing = spacing_type(con);
+			if(spacing == SPACE__COUNT || con.attr1 >= ATTR__COUNT || con.attr2 >= ATTR__COUNT)
+				return STATUS_INVALID_ARGUMENT;
+
+			auto* scope = (Scope*)nullptr;
+			if(_hierarchical)
 			{
-				switch (con.attr2)
-				{
-					case ATTR_LEFT:sp = SPACE_LEFT;break;
-					case ATTR_RIGHT:sp = SPACE_RIGHT;break;
-					case ATTR_WIDTH:sp = SPACE_HORIZ;break;
-					case ATTR_HEIGHT:sp = SPACE_VERT;break;
-					case ATTR_TOP:sp = SPACE_TOP;break;
-					case ATTR_BOTTOM:sp = SPACE_BOTTOM;break;
-					default:
-						throw "unexpected value for -.attr2";
-				}
+				if(auto const status = _placeIn(con, scope))
+					return status;
 			}
-			else
+			auto const& left = _getSubView(con.view1, scope)->_getAttr(con.attr1);
+			auto const* right = con.view2 == "-" ? nullptr : &_getAttr(_getSubView(con.view2, scope), con.attr2, con.attr1);
+			auto strength = kiwi::strength::create(0, con.priority.value_or(500), 1000);
+
+			out = _makeConstraint(left, con.relation, right, con.multiplier.value_or(1), con.constant, spacing, strength, scope);
+			return STATUS_OK;
+        }
+
+        // in a container's scope, its name and ^ stand for the container as its children see it
+        SubView* _getSubView(const std::string& name, Scope* scope)
+        {
+            if(scope && (is_super(name) || name == scope->container->name()))
+                return scope->root.get();
+            return _getSubView(name);
+        }
+
+        // hierarchical mode: the scope con lies in (null: the top level). The first constraint naming a subview
+        // places it; naming it from another scope later is STATUS_INVALID_ARGUMENT, as their coordinates don't meet.
+        Status _placeIn(const ConstraintDef& con, Scope*& out)
+        {
+            auto* container = con.container.empty() ? nullptr : _getSubView(con.container);
+            auto const names = { &con.view1, &con.view2 };
+            auto named = [&](const std::string* name){ return *name != "-" && !is_super(*name) && *name != con.container; };
+
+            // outside cascades (C: lines) a constraint lies where its subviews already are
+            if(!container)
+            {
+                for(auto const* name : names)
+                {
+                    auto* sv = named(name) ? _getSubView(*name) : nullptr;
+                    if(sv && sv->_placed)
+                    {
+                        container = sv->_container;
+                        break;
+                    }
+                }
+            }
+
+            for(auto const* name : names)
+            {
+                if(!named(name))
+                    continue;
+
+                auto* sv = _getSubView(*name);
+                if(!sv->_placed)
+                {
+                    sv->_container = container;
+                    sv->_placed = true;
+                    _scopesOrdered = _scopesOrdered && !_scopeByContainer.count(sv);
+                }
+                else if(sv->_container != container)
+                    return STATUS_INVALID_ARGUMENT;
+            }
+
+            if(!container)
+                return STATUS_OK;
+
+            auto& scope = _scopeByContainer[container];
+            if(!scope)
+            {
+                auto* root = new SubView(_solver);
+                root->_static = _static;
+                _scopes.emplace_back(new Scope{ container, std::unique_ptr<SubView>(root) });
+                scope = _scopes.back().get();
+                _scopesOrdered = false;
+            }
+            out = scope;
+            return STATUS_OK;
+        }
+
+        // hierarchical mode: suggests each container's solved size to its scope where it changed and solves,
+        // one nesting level at a time from the outside in, so scopes whose container kept its size aren't touched
+        void _updateScopes()
+        {
+            if(!_scopesOrdered)
+                _orderScopes();
+
+            for(size_t i=0; i<_scopes.size();)
+            {
+                auto const depth = _scopes[i]->depth;
+                auto changed = false;
+                for(; i<_scopes.size() && _scopes[i]->depth == depth; i++)
+                {
+                    auto& scope = *_scopes[i];
+                    auto const width = scope.container->width(), height = scope.container->height();
+                    if(scope.root->_intrinsicWidth == width && scope.root->_intrinsicHeight == height)
+                        continue;
+
+                    if(!changed)
+                        _solver->beginSuggest();
+                    changed = true;
+                    scope.root->setIntrinsicWidth(width);
+                    scope.root->setIntrinsicHeight(height);
+                }
+
+                if(changed)
+                {
+                    _solver->endSuggest();
+                    _solver->updateVariables();
+                }
+            }
+        }
+
+        // a grid cell a constraint names: the solver gets its attributes as edits, which _updateGrids suggests
+        void _pinCell(SubView* sv)
+        {
+            sv->_pinned = true;
+            auto const strength = kiwi::strength::create(999, 1000, 1000);
+            for(int attr=ATTR_LEFT; attr<ATTR__COUNT; attr++)
+            {
+                auto const& var = *sv->_attr[attr];
+                _solver->addEditVariable(var, strength);
+                _solver->suggestValue(var, _solver->value(var));
+            }
+        }
+
+        // lays each grid out in the frame just solved for it; then solves again for pinned cells that moved
+        void _updateGrids()
+        {
+            if(_grids.empty())
+                return;
+
+            auto suggesting = false;
+            for(auto& grid : _grids)
+            {
+                _sizeTracks(grid, true);
+                _sizeTracks(grid, false);
+
+                auto const left = _solver->value(*grid.view->_attr[ATTR_LEFT]), top = _solver->value(*grid.view->_attr[ATTR_TOP]);
+                auto const gapX = _spacing[SPACE_HORIZ], gapY = _spacing[SPACE_VERT];
+                for(auto const& cell : grid.cells)
+                {
+                    auto const x = left + grid.columnOffsets[cell.column], y = top + grid.rowOffsets[cell.row];
+                    auto const width = grid.columnOffsets[cell.columnEnd] - grid.columnOffsets[cell.column] - gapX;
+                    auto const height = grid.rowOffsets[cell.rowEnd] - grid.rowOffsets[cell.row] - gapY;
+                    double const values[ATTR__COUNT] = { 0, x, x + width, y, y + height, width, height, x + width / 2, y + height / 2 };
+
+                    auto* sv = cell.view;
+                    if(sv->_pinned && !suggesting)
+                    {
+                        _solver->beginSuggest();
+                        suggesting = true;
+                    }
+                    for(int attr=ATTR_LEFT; attr<ATTR__COUNT; attr++)
+                    {
+                        if(sv->_pinned)
+                            _solver->suggestValue(*sv->_attr[attr], values[attr]);
+                        else
+                            _solver->setValue(*sv->_attr[attr], values[attr]);
+                    }
+                }
+            }
+
+            if(suggesting)
+            {
+                _solver->endSuggest();
+                _solver->updateVariables();
+                _updateScopes();
+            }
+        }
+
+        // one axis of grid: fixed and auto tracks first, fr tracks share what they leave of the grid's size.
+        // Fills the offsets with each track's start, then the end; a gap follows every track.
+        void _sizeTracks(Grid& grid, bool horizontal)
+        {
+            auto const& tracks = horizontal ? grid.columns : grid.rows;
+            auto& offsets = horizontal ? grid.columnOffsets : grid.rowOffsets;
+            auto const gap = _spacing[horizontal ? SPACE_HORIZ : SPACE_VERT];
+
+            // sizes in offsets[1..n] until the prefix sum
+            offsets.assign(tracks.size() + 1, 0.0);
+            auto fr = 0.0;
+            for(size_t i=0; i<tracks.size(); i++)
+            {
+                if(tracks[i].sizing == TRACK_FIXED)
+                    offsets[i + 1] = tracks[i].value;
+                else if(tracks[i].sizing == TRACK_FR)
+                    fr += tracks[i].value;
+            }
+            for(auto const& cell : grid.cells)
+            {
+                auto const track = horizontal ? cell.column : cell.row;
+                auto const end = horizontal ? cell.columnEnd : cell.rowEnd;
+                auto const& intrinsic = horizontal ? cell.view->_intrinsicWidth : cell.view->_intrinsicHeight;
+                if(end == track + 1 && intrinsic && tracks[track].sizing == TRACK_AUTO)
+                    offsets[track + 1] = std::max(offsets[track + 1], *intrinsic);
+            }
+
+            auto used = tracks.empty() ? 0.0 : gap * (double)(tracks.size() - 1);
+            for(size_t i=0; i<tracks.size(); i++)
+                used += offsets[i + 1];
+            auto const size = horizontal ? _solver->value(*grid.view->_attr[ATTR_WIDTH]) : _solver->value(*grid.view->_attr[ATTR_HEIGHT]);
+            auto const free = std::max(0.0, size - used);
+            for(size_t i=0; i<tracks.size(); i++)
+            {
+                if(tracks[i].sizing == TRACK_FR && fr > 0)
+                    offsets[i + 1] = free * tracks[i].value / fr;
+            }
+
+            for(size_t i=0; i<tracks.size(); i++)
+                offsets[i + 1] += offsets[i] + gap;
+        }
+
+        // a container can be placed after its scope was made, so depths are settled here
+        void _orderScopes()
+        {
+            for(auto& scope : _scopes)
+            {
+                scope->depth = 0;
+                for(auto* sv = scope->container; sv; sv = sv->_container)
+                    scope->depth++;
+            }
+            std::stable_sort(_scopes.begin(), _scopes.end(), [](auto const& a, auto const& b){ return a->depth < b->depth; });
+            _scopesOrdered = true;
+        }
+
+        // attr of sv as the right side of a constraint on attr1. Numeric sizes are relative to ^.const (a(40) is
+        // a.width == ^.const + 40), which is held at 0; each axis gets its own, so horizontal and vertical
+        // constraints don't meet through it and solve as separate components.
+        const Variable& _getAttr(SubView* sv, Attribute attr, Attribute attr1)
+        {
+            if(sv != _parentSubView || attr != ATTR_CONST)
+                return sv->_getAttr(attr);
+            if(attr1 != ATTR_TOP && attr1 != ATTR_BOTTOM && attr1 != ATTR_HEIGHT && attr1 != ATTR_CENTERY)
+                return sv->_getAttr(attr);
+
+            if(!_verticalConst)
+            {
+                _verticalConst.emplace(_solver->variables().create());
+                _solver->addConstraint(Constraint( *_verticalConst == 0 ));
+            }
+            return *_verticalConst;
+        }
+
+        // right: null for the spacing itself (view2 "-")
+        Constraint _makeConstraint(
+                const Variable& left,
+                Relation relation,
+                const Variable* right,
+                double multiplier,
+                const boost::optional<double>& constant,
+                SpacingType spacing,
+                double strength,
+                Scope* scope = nullptr)
+        {
+            auto cn = _buildConstraint(left, relation, right, multiplier, constant, spacing, strength, scope);
+            if(_static && (!right || !constant))
+            {
+                auto folded = std::make_shared<FoldedConstraint>(FoldedConstraint{ left, relation, {}, multiplier, constant, spacing, strength, cn });
+                if(right)
+                    folded->right = *right;
+                _folded.emplace(cn, std::move(folded));
+            }
+            return cn;
+        }
+
+        Constraint _buildConstraint(
+                const Variable& left,
+                Relation relation,
+                const Variable* rightVar,
+                double multiplier,
+                const boost::optional<double>& constant,
+                SpacingType spacing,
+                double strength,
+                Scope* scope = nullptr) const
+        {
+			auto right = rightVar ? Expression{ Term{ *rightVar } } : -_getSpacing(spacing, scope);
+			if(multiplier != 1)
+				right = right * multiplier;
+
+            if(constant)
+				right = right + *constant;
+            else
+				right = right + _getSpacing(spacing, scope);
+
+            switch(relation)
 			{
-				if((con.view1.empty() || con.view1 == "^") && (con.attr1 == ATTR_LEFT))
-					sp = SPACE_LEFT;
-				else if((con.view1.empty() || con.view1 == "^") && (con.attr1 == ATTR_TOP))
-					sp = SPACE_TOP;
-				else if((con.view2.empty() || con.view2 == "^") && (con.attr2 == ATTR_RIGHT))
-					sp = SPACE_RIGHT;
-				else if((con.view2.empty() || con.view2 == "^") && (con.attr2 == ATTR_BOTTOM))
-					sp = SPACE_BOTTOM;
-				else switch(con.attr1)
-					{
-						case ATTR_LEFT:
-						case ATTR_RIGHT:
-						case ATTR_CENTERY:
-							sp = SPACE_HORIZ;
-							break;
-						default:
-							sp = SPACE_VERT;
-					}
+				case REL_GEQ: return Constraint(left >= right, strength);
+				case REL_LEQ: return Constraint(left <= right, strength);
+				default: return Constraint(left == right, strength);
 			}
+        }
 
-            return _getSpacing(sp);
+        // the constraint a handle stands for in the solver: a folded one's current emission
+        const Constraint& _current(const Constraint& handle) const
+        {
+            auto it = _folded.find(handle);
+            return it == _folded.end() ? handle : it->second->current;
         }
 
-        const kiwi::Expression& _getSpacing(SpacingType sp) const
+        ViewConstraint _handle(const Constraint& cn, Status status = STATUS_OK) const
+        {
+            auto it = _folded.find(cn);
+            return ViewConstraint(cn, status, it == _folded.end() ? nullptr : it->second);
+        }
+
+        // static mode: forgets the handles whose emission isn't in the solver, unless a variant holds them; a
+        // ViewConstraint keeps what addConstraint needs to put one back
+        void _unfold(const std::vector<Constraint>& handles)
+        {
+            for(auto const& cn : handles)
+            {
+                auto it = _folded.find(cn);
+                if(it == _folded.end() || _solver->hasConstraint(it->second->current))
+                    continue;
+
+                auto const held = std::any_of(_variants.begin(), _variants.end(), [&](const auto& kv)
+                {
+                    auto const& cns = kv.second.constraints;
+                    return std::any_of(cns.begin(), cns.end(), [&](const Constraint& c){ return !(c < cn) && !(cn < c); });
+                });
+                if(!held)
+                    _folded.erase(it);
+            }
+        }
+
+        // the constraint to add for a handle; a folded one is re-emitted, as spacing may have changed while it was out
+        const Constraint& _refresh(const Constraint& handle)
+        {
+            auto it = _folded.find(handle);
+            if(it == _folded.end())
+                return handle;
+
+            auto& f = *it->second;
+            f.current = _buildConstraint(f.left, f.relation, f.right.get_ptr(), f.multiplier, f.constant, f.spacing, f.strength);
+            return f.current;
+        }
+
+        // after sweep or solveRows put the view's own inputs back: solved, with changed() against the last update()
+        void _settle()
+        {
+            _solve();
+            if(_changeEpsilon >= 0)
+                _collectChanged();
+        }
+
+        // update() without change tracking, for sweep and solveRows: false if there was nothing to do
+        bool _solve()
+        {
+            if(!_dirty && !_solver->dirty())
+                return false;
+
+            _dirty = false;
+            if(_variant != _applied)
+            {
+                // the solver keeps the other variant until something changes
+                if(_restoreVariant())
+                    return true;
+                if(_applyVariant())
+                {
+                    _variant = _applied;
+                    _variantStats.failed++;
+                }
+            }
+
+            if(_cache.maxBytes())
+            {
+                _makeCacheKey(_cacheKey, (double)_solver->generation());
+                if(_cacheKey == _currentKey)
+                    return false;
+
+                if(auto const* values = _cache.find(_cacheKey))
+                {
+                    _restore(*values);
+                    _cacheRestored = true;
+                }
+                else
+                {
+                    if(_cacheRestored)
+                        _solver->invalidateVariables();
+                    _cacheRestored = false;
+                    _solver->updateVariables();
+                    _updateScopes();
+                    _updateGrids();
+                    _cache.store(_cacheKey, _snapshot());
+                }
+                _currentKey = _cacheKey;
+            }
+            else
+            {
+                if(_cacheRestored)
+                    _solver->invalidateVariables();
+                _cacheRestored = false;
+                _solver->updateVariables();
+                _updateScopes();
+                _updateGrids();
+            }
+            return true;
+        }
+
+        // the active variant's last solved values, if they were solved for the current inputs
+        bool _restoreVariant()
+        {
+            if(_variant.empty())
+                return false;
+
+            auto const& variant = _variants.at(_variant);
+            _makeCacheKey(_cacheKey, (double)_constraintEpoch);
+            if(variant.values.empty() || _cacheKey != variant.key)
+                return false;
+
+            _restore(variant.values);
+            _cacheRestored = true;
+            _currentKey.clear();
+            _variantStats.restored++;
+            return true;
+        }
+
+        // swaps the applied variant's constraints for the active one's, optimizing once; on failure the solver
+        // keeps the applied one's
+        Status _applyVariant()
+        {
+            auto remove = std::vector<Constraint>{}, add = std::vector<Constraint>{};
+            if(!_applied.empty())
+            {
+                for(auto const& cn : _variants.at(_applied).constraints)
+                    remove.push_back(_current(cn));
+            }
+            if(!_variant.empty())
+            {
+                for(auto const& cn : _variants.at(_variant).constraints)
+                    add.push_back(_refresh(cn));
+            }
+
+            if(auto const status = _solver->replaceConstraints(remove, add))
+                return status;
+            _applied = _variant;
+            _variantStats.applied++;
+            return STATUS_OK;
+        }
+
+        // static mode: swap the folded constraints that use sp for ones with its new value; one the solver won't
+        // take keeps its old emission, so its handle still finds it
+        void _refold(SpacingType sp)
+        {
+            for(auto& [handle, folded] : _folded)
+            {
+                auto& f = *folded;
+                if(f.spacing != sp || !_solver->hasConstraint(f.current))
+                    continue;
+
+                auto const old = f.current;
+                auto const next = _buildConstraint(f.left, f.relation, f.right.get_ptr(), f.multiplier, f.constant, f.spacing, f.strength);
+                if(_solver->removeConstraint(old))
+                    continue;
+                if(_solver->addConstraint(next))
+                    _solver->addConstraint(old);
+                else
+                    f.current = next;
+            }
+        }
+
+        // scope: hierarchical mode, where the constraint lies; each has its own spacing variables
+        Expression _getSpacing(SpacingType sp, Scope* scope = nullptr) const
 		{
-			if(!_spacingVars[sp])
+			if(_static)
+				return Expression(-_spacing[sp]);
+
+			auto& vars = scope ? scope->spacingVars : _spacingVars;
+			auto& exprs = scope ? scope->spacingExpr : _spacingExpr;
+			if(!vars[sp])
 			{
-				auto& var = *(_spacingVars[sp] = kiwi::Variable());
-				_solver->addEditVariable(var, kiwi::strength::create(999, 1000, 1000));
-				_spacingExpr[sp] = -var;
-				_solver->suggestValue(var, _spacing[sp]);
+				if(!scope && _spacingPool[sp])
+				{
+					vars[sp] = _spacingPool[sp]->first;
+					exprs[sp] = std::move(_spacingPool[sp]->second);
+					_spacingPool[sp].reset();
+				}
+				else
+				{
+					vars[sp] = _solver->variables().create();
+					exprs[sp] = -*vars[sp];
+				}
+				_solver->addEditVariable(*vars[sp], kiwi::strength::create(999, 1000, 1000));
+				_solver->suggestValue(*vars[sp], _spacing[sp]);
 			}
 
-			return *_spacingExpr[sp];
+			return *exprs[sp];
 		}
     };
 }
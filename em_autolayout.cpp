@@ -8,6 +8,7 @@
 #include <emscripten/val.h>
 #include <emscripten/emscripten.h>
 
+#include "autolayout/handles.h"
 #include "autolayout/view.h"
 
 using namespace emscripten;
@@ -139,6 +140,30 @@ using namespace autolayout;
 //    return (size_t) new ConstraintDef(constraintDefCtor(dto));
 //}
 
+// logs a failed status under the caller's name and passes it on
+static Status logged(Status status, const char* func)
+{
+    if(status)
+        emscripten_log(EM_LOG_ERROR, "%s: %s", func, status_str(status));
+    return status;
+}
+
+// the object behind a handle (see HandleRegistry), or null, logged, if it's released or of another type
+template<typename T>
+static T* handleOf(size_t handle, const char* func)
+{
+    auto* object = handles().get<T>(handle);
+    if(!object)
+        emscripten_log(EM_LOG_ERROR, "%s: not a live handle", func);
+    return object;
+}
+
+// collected ViewConstraints as a handle, or 0 without
+static size_t handleFor(std::unique_ptr<std::vector<ViewConstraint>> out)
+{
+    return out ? handles().add(std::move(out)) : 0;
+}
+
 namespace view
 {
     static val* class_ConstraintDef;  //= val::module_property("ConstraintDef");
@@ -191,80 +216,349 @@ namespace view
 //            return val(self.addConstraint(constraintDefCtor(con_or_def_or_json)));
 //    }
 
-    void addViewConstraintBack(View& self, const val& viewCon)
+    Status addViewConstraintBack(View& self, const val& viewCon)
     {
-        self.addConstraint(viewCon.as<ViewConstraint>());
+        return logged(self.addConstraint(viewCon.as<ViewConstraint>()).status(), __func__);
     }
 
-    void removeViewConstraint(View& self, const val& viewCon)
+    Status removeViewConstraint(View& self, const val& viewCon)
     {
-        self.removeConstraint(viewCon.as<ViewConstraint>());
+        return logged(self.removeConstraint(viewCon.as<ViewConstraint>()), __func__);
     }
 
-    void removeConstraint(View& self, const val& viewCon)
+    Status removeConstraint(View& self, const val& viewCon)
     {
         if(! viewCon.instanceof(*class_ViewConstraint))
-            emscripten_log(EM_LOG_ERROR, "%s: argument must be a ViewConstraint instance", __func__);
-        else
-            self.removeConstraint(viewCon.as<ViewConstraint>());
+            return logged(STATUS_INVALID_ARGUMENT, __func__);
+        return logged(self.removeConstraint(viewCon.as<ViewConstraint>()), __func__);
     }
 
 
-    ViewConstraint raw_addConstraint(View& self, size_t def)
+    // one ConstraintDef of a parse result's handle; STATUS_OUT_OF_RANGE for an index past its end
+    ViewConstraint raw_addConstraint(View& self, size_t vecOfDef, size_t index)
     {
-        return self.addConstraint(*(ConstraintDef*)def);
+        auto* vec = handleOf<std::vector<ConstraintDef>>(vecOfDef, __func__);
+        if(!vec)
+            return ViewConstraint(STATUS_INVALID_ARGUMENT);
+        auto* con = handles().element<ConstraintDef>(vecOfDef, index);
+        if(!con)
+            return ViewConstraint(logged(STATUS_OUT_OF_RANGE, __func__));
+
+        auto const out = self.addConstraint(*con);
+        logged(out.status(), __func__);
+        return out;
     }
 
+    // a handle to the collected ViewConstraints; 0 on failure or without collect
     size_t raw_addConstraints(View& self, size_t vecOfDef, bool collect)
 	{
-		auto* vec = (std::vector<ConstraintDef>*)vecOfDef;
-
-		if(collect)
-		{
-			auto* out = new std::vector<ViewConstraint>();
-			out->reserve(vec->size());
+		auto* vec = handleOf<std::vector<ConstraintDef>>(vecOfDef, __func__);
+		if(!vec)
+			return 0;
 
-			for(auto const& def : *vec)
-				out->emplace_back(self.addConstraint(def));
-			return (size_t)(void*)out;
-		}
-		else
-		{
-			for(auto const& def : *vec)
-				self.addConstraint(def);
+		auto out = collect ? std::make_unique<std::vector<ViewConstraint>>() : nullptr;
+		if(logged(self.addConstraints(*vec, out.get()), __func__))
 			return 0;
-		}
+		return handleFor(std::move(out));
 
 	}
 
+    // queued for step(), which adds and solves them a time budget at a time (see stepAsync in post.js);
+    // copied, so the handle can be released right away
+    Status raw_queueConstraints(View& self, size_t vecOfDef)
+    {
+        auto* vec = handleOf<std::vector<ConstraintDef>>(vecOfDef, __func__);
+        if(!vec)
+            return STATUS_INVALID_ARGUMENT;
+        self.queueConstraints(*vec);
+        return STATUS_OK;
+    }
+
+    // Results of step(): a StepResult, or a failed Status negated
+    int step(View& self, double budgetMicros)
+    {
+        auto const result = self.step(budgetMicros);
+        return result.ok() ? (int)result.value : -(int)logged(result.status, __func__);
+    }
+
+    // grids before the constraints that name their cells; the first failure, the others added anyway
+    Status raw_addGrids(View& self, size_t vecOfGrid)
+    {
+        auto* vec = handleOf<std::vector<GridDef>>(vecOfGrid, __func__);
+        if(!vec)
+            return STATUS_INVALID_ARGUMENT;
+
+        auto status = STATUS_OK;
+        for(auto const& grid : *vec)
+        {
+            auto const added = logged(self.addGrid(grid), __func__);
+            status = status ? status : added;
+        }
+        return status;
+    }
+
+    Status raw_addVariant(View& self, const std::string& name, size_t vecOfDef)
+    {
+        auto* vec = handleOf<std::vector<ConstraintDef>>(vecOfDef, __func__);
+        if(!vec)
+            return STATUS_INVALID_ARGUMENT;
+        return logged(self.addVariant(name, *vec), __func__);
+    }
+
+    Status setVariant(View& self, const std::string& name)
+    {
+        return logged(self.setVariant(name), __func__);
+    }
+
+    Status setHierarchical(View& self, bool on)
+    {
+        return logged(self.setHierarchical(on), __func__);
+    }
+
+    Status setArena(View& self, bool on)
+    {
+        return logged(self.setArena(on), __func__);
+    }
+
+    // {chunks, reserved, used, allocations, recycled}; zeros without an arena
+    val arenaStats(View& self)
+    {
+        auto const stats = self.arenaStats();
+        auto out = val::object();
+        out.set("chunks", (double)stats.chunks);
+        out.set("reserved", (double)stats.reserved);
+        out.set("used", (double)stats.used);
+        out.set("allocations", (double)stats.allocations);
+        out.set("recycled", (double)stats.recycled);
+        return out;
+    }
+
+    // a handle to the collected ViewConstraints; 0 on failure or without collect
+    size_t raw_instantiate(View& self, const CompiledLayout& layout, bool collect)
+    {
+        auto out = collect ? std::make_unique<std::vector<ViewConstraint>>() : nullptr;
+        if(logged(self.instantiate(layout, out.get()), __func__))
+            return 0;
+        return handleFor(std::move(out));
+    }
+
+    // names in index order, so frames can be matched up once
+    val getSubViewNames(View& self)
+    {
+        auto out = val::array();
+        for(size_t i=0; i<self.subViewCount(); i++)
+            out.call<void>("push", self.getSubView(i)->name());
+        return out;
+    }
+
+    // Float64Array/Float32Array of [left, top, width, height] per subview, viewing the View's buffer in the heap.
+    // Copy or re-fetch after growing the heap or calling again.
+    val frames(View& self)
+    {
+        return val(typed_memory_view(self.subViewCount() * 4, self.frames()));
+    }
+
+    val frames32(View& self)
+    {
+        return val(typed_memory_view(self.subViewCount() * 4, self.frames32()));
+    }
+
+    // {suggestions, skippedSuggestions, updates, skippedUpdates}
+    val stats(View& self)
+    {
+        auto const stats = self.stats();
+        auto out = val::object();
+        out.set("suggestions", (double)stats.suggestions);
+        out.set("skippedSuggestions", (double)stats.skippedSuggestions);
+        out.set("updates", (double)stats.updates);
+        out.set("skippedUpdates", (double)stats.skippedUpdates);
+        return out;
+    }
+
+    // {switches, restored, applied, failed}: failed counts swaps the solver refused, which update() rolled back
+    val variantStats(View& self)
+    {
+        auto const& stats = self.variantStats();
+        auto out = val::object();
+        out.set("switches", (double)stats.switches);
+        out.set("restored", (double)stats.restored);
+        out.set("applied", (double)stats.applied);
+        out.set("failed", (double)stats.failed);
+        return out;
+    }
+
+    // {hits, misses, evictions, entries, bytes}
+    val cacheStats(View& self)
+    {
+        auto const& stats = self.cacheStats();
+        auto out = val::object();
+        out.set("hits", (double)stats.hits);
+        out.set("misses", (double)stats.misses);
+        out.set("evictions", (double)stats.evictions);
+        out.set("entries", (double)stats.entries);
+        out.set("bytes", (double)stats.bytes);
+        return out;
+    }
+
+    // Uint32Array view of the indices the last update() found moved (see View::trackChanges)
+    val changed(View& self)
+    {
+        auto const& out = self.changed();
+        return val(typed_memory_view(out.size(), out.data()));
+    }
+
+    // sizes: Float64Array of [width, height] pairs; returns a Float64Array view of the View's buffer holding
+    // [left, top, width, height] per subview per size, sizes in order
+    val sweep(View& self, const val& sizes)
+    {
+        auto const len = sizes["length"].as<size_t>();
+        std::vector<double> buf(len);
+        val(typed_memory_view(len, buf.data())).call<void>("set", sizes);
+
+        auto const count = len / 2;
+        return val(typed_memory_view(count * self.subViewCount() * 4, self.sweep(buf.data(), count)));
+    }
+
+    void raw_sweep(View& self, size_t sizes, size_t count, size_t out)
+    {
+        self.sweep((const double*)sizes, count, (double*)out);
+    }
+
+    // params: Uint32Array of [index, axis] pairs (axis 0: width, 1: height); values: Float64Array of one value
+    // per param per row. Returns a Float64Array of [left, top, width, height] per subview per row; its
+    // "solved" property tells how many rows needed a solve. Undefined for an unknown subview index or a pair
+    // given twice.
+    val solveRows(View& self, const val& params, const val& values)
+    {
+        auto const paramLen = params["length"].as<size_t>();
+        std::vector<uint32_t> paramBuf(paramLen);
+        val(typed_memory_view(paramLen, paramBuf.data())).call<void>("set", params);
+
+        auto const len = values["length"].as<size_t>();
+        std::vector<double> buf(len);
+        val(typed_memory_view(len, buf.data())).call<void>("set", values);
+
+        auto const paramCount = paramLen / 2;
+        auto const count = paramCount ? len / paramCount : 0;
+        auto out = val::global("Float64Array").new_(count * self.subViewCount() * 4);
+        std::vector<double> frames(count * self.subViewCount() * 4);
+        auto const solved = self.solveRows(paramBuf.data(), paramCount, buf.data(), count, frames.data());
+        if(logged(solved.status, __func__))
+            return val::undefined();
+        out.call<void>("set", val(typed_memory_view(frames.size(), frames.data())));
+        out.set("solved", solved.value);
+        return out;
+    }
+
+    // same, for params, values and a 4 * subViewCount() * count output the caller already has in the wasm heap;
+    // -1 for an unknown subview index or a pair given twice
+    double raw_solveRows(View& self, size_t params, size_t paramCount, size_t values, size_t count, size_t out)
+    {
+        auto const solved = self.solveRows((const uint32_t*)params, paramCount, (const double*)values, count, (double*)out);
+        return logged(solved.status, __func__) ? -1 : (double)solved.value;
+    }
+
+    // into a caller-allocated heap buffer of 4 * subViewCount() values
+    void raw_writeFrames(View& self, size_t out)
+    {
+        self.writeFrames((double*)out);
+    }
+
+    void raw_writeFrames32(View& self, size_t out)
+    {
+        self.writeFrames((float*)out);
+    }
+
+    // records: Float64Array of [index, width, height], NaN to clear; copied into the heap in one go
+    size_t setIntrinsicSizes(View& self, const val& records)
+    {
+        auto const len = records["length"].as<size_t>();
+        std::vector<double> buf(len);
+        val(typed_memory_view(len, buf.data())).call<void>("set", records);
+        return self.setIntrinsicSizes(buf.data(), len / 3);
+    }
+
+    // same, for records the caller already wrote into the wasm heap
+    size_t raw_setIntrinsicSizes(View& self, size_t records, size_t count)
+    {
+        return self.setIntrinsicSizes((const double*)records, count);
+    }
+
     //todo:
     //addConstraint-S
 
-    void raw_addViewConstraintBack(View& self, const ViewConstraint &viewCon)
+    Status raw_addViewConstraintBack(View& self, const ViewConstraint &viewCon)
     {
-        self.addConstraint(viewCon);
+        return logged(self.addConstraint(viewCon).status(), __func__);
     }
 
-    void raw_removeViewConstraint(View& self, const ViewConstraint &viewCon)
+    Status raw_removeViewConstraint(View& self, const ViewConstraint &viewCon)
     {
-        self.removeConstraint(viewCon);
+        return logged(self.removeConstraint(viewCon), __func__);
     }
 
-    void raw_addViewConstraintsBack(View& self, size_t vecOfViewCons)
+    // the first failure; the others still go in
+    Status raw_addViewConstraintsBack(View& self, size_t vecOfViewCons)
 	{
-    	auto* vec = (std::vector<ViewConstraint>*) vecOfViewCons;
+    	auto* vec = handleOf<std::vector<ViewConstraint>>(vecOfViewCons, __func__);
+    	if(!vec)
+    		return STATUS_INVALID_ARGUMENT;
+    	auto status = STATUS_OK;
+    	self.beginBatch();
     	for(auto const& vc : *vec)
-    		self.addConstraint(vc);
+    	{
+    		auto const added = self.addConstraint(vc).status();
+    		status = status ? status : added;
+    	}
+    	self.commit();
+    	return logged(status, __func__);
 	}
 
-	void raw_removeViewConstraints(View& self, size_t vecOfViewCons)
+	Status raw_removeViewConstraints(View& self, size_t vecOfViewCons)
 	{
-		auto* vec = (std::vector<ViewConstraint>*) vecOfViewCons;
+		auto* vec = handleOf<std::vector<ViewConstraint>>(vecOfViewCons, __func__);
+		if(!vec)
+			return STATUS_INVALID_ARGUMENT;
+		auto status = STATUS_OK;
+		self.beginBatch();
 		for(auto const& vc : *vec)
-			self.removeConstraint(vc);
+		{
+			auto const removed = self.removeConstraint(vc);
+			status = status ? status : removed;
+		}
+		self.commit();
+		return logged(status, __func__);
 	}
 }
 
+namespace compiledlayout
+{
+    std::shared_ptr<CompiledLayout> raw_compile(size_t vecOfDef)
+    {
+        auto* vec = handleOf<std::vector<ConstraintDef>>(vecOfDef, __func__);
+        return vec ? CompiledLayout::compile(*vec) : nullptr;
+    }
+}
+
+namespace handle
+{
+    // {live, bytes, added, released}
+    val stats()
+    {
+        auto const& stats = handles().stats();
+        auto out = val::object();
+        out.set("live", (double)stats.live);
+        out.set("bytes", (double)stats.bytes);
+        out.set("added", (double)stats.added);
+        out.set("released", (double)stats.released);
+        return out;
+    }
+
+    bool release(size_t handle) { return handles().release(handle); }
+    size_t beginArena() { return handles().beginArena(); }
+    size_t endArena() { return handles().endArena(); }
+}
+
 namespace subview
 {
     val intrinsicWidth(SubView& self)
@@ -308,25 +602,101 @@ EMSCRIPTEN_BINDINGS(View)
 //            .constructor(&constraintDefCtor)
 //            ;
 
+    enum_<StepResult>("StepResult")
+            .value("DONE", STEP_DONE)
+            .value("MORE", STEP_MORE);
+
+    enum_<Status>("Status")
+            .value("OK", STATUS_OK)
+            .value("DUPLICATE_CONSTRAINT", STATUS_DUPLICATE_CONSTRAINT)
+            .value("UNKNOWN_CONSTRAINT", STATUS_UNKNOWN_CONSTRAINT)
+            .value("UNSATISFIABLE_CONSTRAINT", STATUS_UNSATISFIABLE_CONSTRAINT)
+            .value("INVALID_ARGUMENT", STATUS_INVALID_ARGUMENT)
+            .value("INVALID_STATE", STATUS_INVALID_STATE)
+            .value("OUT_OF_RANGE", STATUS_OUT_OF_RANGE);
+
+    function("statusName", optional_override([](int status){ return std::string(status_str((Status)status)); }));
+
+    // parse results and collected ViewConstraints are handles: release each, or scope them in an arena
+    function("release", &handle::release);
+    function("beginArena", &handle::beginArena);
+    function("endArena", &handle::endArena);
+    function("handleStats", &handle::stats);
+
     class_<View>("View")
             .constructor()
+            .constructor<bool>()
+            .function("isStatic", &View::isStatic)
             .function("setSpacing", &view::setSpacing)
             //.function("addConstraint", &view::addConstraint)
             .function("addViewConstraintBack", &view::addViewConstraintBack)
 
             .function("raw_addConstraint", &view::raw_addConstraint, allow_raw_pointers())
             .function("raw_addConstraints", &view::raw_addConstraints, allow_raw_pointers())
+            .function("raw_addGrids", &view::raw_addGrids, allow_raw_pointers())
+            .function("raw_queueConstraints", &view::raw_queueConstraints, allow_raw_pointers())
+            .function("step", &view::step)
+            .function("loading", &View::loading)
+            .function("gridCount", &View::gridCount)
+            .function("raw_addVariant", &view::raw_addVariant, allow_raw_pointers())
+            .function("setVariant", &view::setVariant)
+            .function("variant", &View::variant)
+            .function("variantStats", &view::variantStats)
+            .function("componentCount", &View::componentCount)
+            .function("closedFormConstraints", &View::closedFormConstraints)
+            .function("setHierarchical", &view::setHierarchical)
+            .function("isHierarchical", &View::isHierarchical)
+            .function("setArena", &view::setArena)
+            .function("hasArena", &View::hasArena)
+            .function("arenaStats", &view::arenaStats)
+            .function("compact", &View::compact)
+            .function("setAutoCompact", &View::setAutoCompact)
+            .function("autoCompacted", &View::autoCompacted)
+            .function("memoryBytes", &View::memoryBytes)
             .function("raw_addViewConstraintBack", &view::raw_addViewConstraintBack, allow_raw_pointers())
             .function("raw_removeViewConstraint", &view::raw_removeViewConstraint, allow_raw_pointers())
 
             .function("raw_addViewConstraintsBack", &view::raw_addViewConstraintsBack, allow_raw_pointers())
             .function("raw_removeViewConstraints", &view::raw_removeViewConstraints, allow_raw_pointers())
+            .function("raw_instantiate", &view::raw_instantiate, allow_raw_pointers())
 
             .function("removeViewConstraint", &view::removeViewConstraint)
             .function("removeConstraint", &view::removeConstraint)
             .function("setSize", &View::setSize)
             .function("getSubViews", &view::getSubViews)
+            .function("subViewCount", &View::subViewCount)
+            .function("getSubView", &View::getSubView, allow_raw_pointers())
+            .function("indexOf", &View::indexOf)
+            .function("getSubViewNames", &view::getSubViewNames)
+            .function("frames", &view::frames)
+            .function("frames32", &view::frames32)
+            .function("raw_writeFrames", &view::raw_writeFrames, allow_raw_pointers())
+            .function("raw_writeFrames32", &view::raw_writeFrames32, allow_raw_pointers())
+            .function("sweep", &view::sweep)
+            .function("raw_sweep", &view::raw_sweep, allow_raw_pointers())
+            .function("solveRows", &view::solveRows)
+            .function("raw_solveRows", &view::raw_solveRows, allow_raw_pointers())
+            .function("setIntrinsicSizes", &view::setIntrinsicSizes)
+            .function("raw_setIntrinsicSizes", &view::raw_setIntrinsicSizes, allow_raw_pointers())
             .function("update", &View::update)
+            .function("trackChanges", &View::trackChanges)
+            .function("dirty", &View::dirty)
+            .function("stats", &view::stats)
+            .function("enableCache", &View::enableCache)
+            .function("cacheStats", &view::cacheStats)
+            .function("changed", &view::changed)
+            .function("beginBatch", &View::beginBatch)
+            .function("commit", &View::commit)
+            .function("inBatch", &View::inBatch)
+            .function("beginSuggest", &View::beginSuggest)
+            .function("endSuggest", &View::endSuggest)
+            ;
+
+    class_<CompiledLayout>("CompiledLayout")
+            .smart_ptr<std::shared_ptr<CompiledLayout>>("CompiledLayout")
+            .class_function("raw_compile", &compiledlayout::raw_compile, allow_raw_pointers())
+            .function("slotCount", &CompiledLayout::slotCount)
+            .function("size", &CompiledLayout::size)
             ;
 
     class_<SubView>("SubView")
@@ -340,6 +710,7 @@ EMSCRIPTEN_BINDINGS(View)
             .function("height", &SubView::height)
             .function("name", &SubView::name)
             .function("type", &SubView::type)
+            .function("index", &SubView::index)
             .function("intrinsicWidth", &subview::intrinsicWidth)
             .function("intrinsicHeight", &subview::intrinsicHeight)
             .function("setIntrinsicWidth", &subview::setIntrinsicWidth)
@@ -358,6 +729,7 @@ EMSCRIPTEN_BINDINGS(View)
 //            ;
 
     class_<ViewConstraint>("ViewConstraint")
+            .function("status", &ViewConstraint::status)
             ;
 
     //static val class_ConstraintDef = val::module_property("ConstraintDef");
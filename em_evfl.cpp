@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <string>
 #include <boost/spirit/home/x3.hpp>
 #include <boost/spirit/home/x3/version.hpp>
@@ -10,16 +11,29 @@
 #include "evfl/syntax.hpp"
 #include "evfl/visit.hpp"
 #include "autolayout/constraint_def.h"
+#include "autolayout/grid_def.h"
+#include "autolayout/handles.h"
 
 using namespace emscripten;
 
-//opaque pointer
+#ifdef BOOST_NO_EXCEPTIONS
+// built with -fno-exceptions (AUTOLAYOUT_EXCEPTIONS=OFF): what boost would throw aborts instead
+namespace boost
+{
+    void throw_exception(const std::exception&) { std::abort(); }
+#if BOOST_VERSION >= 107300
+    void throw_exception(const std::exception&, const boost::source_location&) { std::abort(); }
+#endif
+}
+#endif
+
+//handle (see HandleRegistry): release it, or parse inside an arena
 size_t parse_evfl(std::string input, val defPrio)
 {
     namespace x3 = boost::spirit::x3;
     namespace ascii = x3::ascii;
 
-	auto* output = new std::vector<evfl::ast::ConstraintDef>{};
+	auto output = std::make_unique<std::vector<evfl::ast::ConstraintDef>>();
 	output->reserve(16);
 
 	auto begin = input.begin();
@@ -43,10 +57,32 @@ size_t parse_evfl(std::string input, val defPrio)
 		}
 	}
 
-	return (size_t)(void*)output;
+	return autolayout::handles().add(std::move(output));
+}
+
+//handle to the grids of the input's G: lines (parse_evfl skips them), for View.raw_addGrids
+size_t parse_evfl_grids(std::string input)
+{
+    namespace x3 = boost::spirit::x3;
+
+	auto output = std::make_unique<std::vector<autolayout::GridDef>>();
+
+	auto begin = input.begin();
+	auto end = input.end();
+	evfl::ast::MultiExtendedVisualFormat ast;
+	auto ok = x3::parse(begin, end, evfl::multiExtendedVisualFormat, ast);
+
+	if(!ok || begin != end)
+		emscripten_log(EM_LOG_ERROR, "%s: error parsing at %d: %s", __func__, begin-input.begin(), input.data());
+
+	std::vector<evfl::ast::ConstraintDef> defs;
+	evfl::visit::visitMultiEvfl(ast, defs, output.get());
+
+	return autolayout::handles().add(std::move(output));
 }
 
 EMSCRIPTEN_BINDINGS(evfl)
 {
     function("parse_evfl", &parse_evfl, allow_raw_pointers());
+    function("parse_evfl_grids", &parse_evfl_grids, allow_raw_pointers());
 }
@@ -0,0 +1,55 @@
+// Every global operator new, counted for the benches' allocation figures. Linked into the native build only with
+// AUTOLAYOUT_COUNT_ALLOCATIONS=ON, so the tests otherwise run on the standard allocator. Each form of new has its
+// matching delete; all of them come from malloc/aligned_alloc and go back through free.
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+uint64_t heapAllocations = 0;
+
+static void* allocate(size_t bytes)
+{
+    heapAllocations++;
+    return std::malloc(bytes ? bytes : 1);
+}
+
+static void* allocate(size_t bytes, std::align_val_t alignment)
+{
+    heapAllocations++;
+    auto const align = (size_t)alignment;
+    return std::aligned_alloc(align, (bytes + align - 1) / align * align);
+}
+
+template<typename... A>
+static void* allocateOrFail(size_t bytes, A... alignment)
+{
+    if(auto* p = allocate(bytes, alignment...))
+        return p;
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+    throw std::bad_alloc();
+#else
+    std::abort();
+#endif
+}
+
+void* operator new(size_t bytes) { return allocateOrFail(bytes); }
+void* operator new[](size_t bytes) { return allocateOrFail(bytes); }
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept { return allocate(bytes); }
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept { return allocate(bytes); }
+void* operator new(size_t bytes, std::align_val_t alignment) { return allocateOrFail(bytes, alignment); }
+void* operator new[](size_t bytes, std::align_val_t alignment) { return allocateOrFail(bytes, alignment); }
+void* operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(bytes, alignment); }
+void* operator new[](size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(bytes, alignment); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
@@ -6,6 +6,7 @@
 #include <boost/variant/variant.hpp>
 #include <boost/spirit/home/x3/support/ast/variant.hpp>
 #include "../autolayout/constraint_def.h"
+#include "../autolayout/grid_def.h"
 
 namespace evfl::ast
 {
@@ -155,7 +156,17 @@ namespace evfl::ast
 
     using MultiConstraintFormatRow = std::vector<ConstraintFormat>;
 
-    using MultiExtendedVisualFormat = std::vector<x3::variant<MultiVisualFormatRow, MultiConstraintFormatRow>>;
+    struct GridFormat
+    {
+        std::string name;
+        boost::optional<std::vector<Track>> columns;
+        boost::optional<std::vector<Track>> rows;
+        std::vector<std::vector<std::string>> cells;    // "" for an empty slot (.)
+    };
+
+    using MultiGridFormatRow = std::vector<GridFormat>;
+
+    using MultiExtendedVisualFormat = std::vector<x3::variant<MultiVisualFormatRow, MultiConstraintFormatRow, MultiGridFormatRow>>;
 }
 
 #include <boost/fusion/include/adapt_struct.hpp>
@@ -172,3 +183,5 @@ BOOST_FUSION_ADAPT_STRUCT(evfl::ast::AttributePredicate, attribute, predicates);
 BOOST_FUSION_ADAPT_STRUCT(evfl::ast::VisualFormat, orientation, _superTo, rest, __toSuper, _toSuper);
 BOOST_FUSION_ADAPT_STRUCT(evfl::ast::ConstraintFormat, viewName, predicates);
 BOOST_FUSION_ADAPT_STRUCT(evfl::ast::MultiVisualFormatRow, orientation, items);
+BOOST_FUSION_ADAPT_STRUCT(autolayout::Track, sizing, value);
+BOOST_FUSION_ADAPT_STRUCT(evfl::ast::GridFormat, name, columns, rows, cells);
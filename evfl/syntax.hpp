@@ -237,6 +237,30 @@ namespace evfl
     auto const visualFmtContent = -superview >> +(connection >> viewGroup) >> connection >> -superview;
     auto const constraintFmtContent = (viewName | ('['>> (viewName % ',') >>']')) >> +(attribute >> '(' >> (predicate % ',') >> ')');
 
+    // 120 points, 2fr shares, auto
+    const rule<class track, ast::Track> track("track");
+    auto const track_def =
+              (x3::attr(ast::TRACK_FR) >> number >> "fr")
+            | (x3::attr(ast::TRACK_FIXED) >> number)
+            | (lit("auto") >> x3::attr(ast::TRACK_AUTO) >> x3::attr(0.0));
+
+    const rule<class trackList, std::vector<ast::Track>> trackList("trackList");
+    auto const trackList_def =
+            '(' >> (track % ',') >> ')';
+
+    const rule<class gridCell, std::string> gridCell("gridCell");
+    auto const gridCell_def =
+            viewName | (lit('.') >> x3::attr(std::string()));
+
+    const rule<class gridRow, std::vector<std::string>> gridRow("gridRow");
+    auto const gridRow_def =
+            '[' >> (gridCell % ',') >> ']';
+
+    // g(columns)(rows)[a,b][c,.]
+    const rule<class gridFormat, ast::GridFormat> gridFormat("gridFormat");
+    auto const gridFormat_def =
+            viewName >> -trackList >> -trackList >> +gridRow;
+
 //	auto const extendedVisualFormat_def =
 //			     ("C:" >> constraintFmtContent)
 //			   | (orient >> visualFmtContent);
@@ -250,9 +274,10 @@ namespace evfl
 			lineSeparator >> (
 				(
 						("C:" >> constraintFmtContent % spaces )
+					  | ("G:" >> gridFormat % spaces )
 					  | (orient >> (x3::attr(ast::ORIENT_NONE) >> visualFmtContent) % spaces )
 				) % lineSeparator
 			) >> lineSeparator;
 
-	BOOST_SPIRIT_DEFINE(multiplier,percent, predicateList, predicate, connection, cascadedViews, viewGroup, view, multiExtendedVisualFormat);
+	BOOST_SPIRIT_DEFINE(multiplier,percent, predicateList, predicate, connection, cascadedViews, viewGroup, view, track, trackList, gridCell, gridRow, gridFormat, multiExtendedVisualFormat);
 }
@@ -1,4 +1,6 @@
 #include <string>
+#include <chrono>
+#include <limits>
 #include <iostream>
 #include <boost/spirit/home/x3.hpp>
 #include <boost/spirit/home/x3/version.hpp>
@@ -8,11 +10,30 @@
 #include "ast.hpp"
 #include "syntax.hpp"
 #include "../autolayout/constraint_def.h"
+#include "../autolayout/handles.h"
 #include "../autolayout/view.h"
 #include "visit.hpp"
 
 using namespace std::string_literals;
 
+#ifdef BOOST_NO_EXCEPTIONS
+// built with -fno-exceptions (AUTOLAYOUT_EXCEPTIONS=OFF): what boost would throw aborts instead
+namespace boost
+{
+    void throw_exception(const std::exception&) { std::abort(); }
+#if BOOST_VERSION >= 107300
+    void throw_exception(const std::exception&, const boost::source_location&) { std::abort(); }
+#endif
+}
+#endif
+
+#ifdef AUTOLAYOUT_COUNT_ALLOCATIONS
+// every global operator new (alloc_count.cpp), for the benches' allocation counts
+extern uint64_t heapAllocations;
+#else
+static uint64_t const heapAllocations = 0;
+#endif
+
 namespace evfl::test
 {
     namespace x3 = boost::spirit::x3;
@@ -294,6 +315,1063 @@ namespace evfl::test
     	assert(defs.size() == 17);
 	}
 
+    std::vector<ast::ConstraintDef> parse(const std::string& input, std::vector<ast::GridDef>* grids = nullptr)
+    {
+        auto begin = input.begin();
+        auto end = input.end();
+        ast::MultiExtendedVisualFormat out;
+        auto ok = x3::parse(begin, end, evfl::multiExtendedVisualFormat, out);
+        assert(ok);
+        assert(begin == end);
+
+        std::vector<ast::ConstraintDef> defs;
+        evfl::visit::visitMultiEvfl(out, defs, grids);
+        return defs;
+    }
+
+    bool sameFrames(autolayout::View& expected, autolayout::View& actual)
+    {
+        for(auto& [name, sv] : expected.getSubViews())
+        {
+            auto it = actual.getSubViews().find(name);
+            if(it == actual.getSubViews().end())
+                return false;
+
+            auto* other = it->second;
+            if(abs(sv->left() - other->left()) > 1e-6 || abs(sv->top() - other->top()) > 1e-6 ||
+               abs(sv->width() - other->width()) > 1e-6 || abs(sv->height() - other->height()) > 1e-6)
+                return false;
+        }
+        return true;
+    }
+
+    void compiledLayout()
+    {
+        auto defs = parse("H:|-[a]-[b(a)]-| V:|-[a]-| V:|-[b]-|"s);
+        auto layout = autolayout::CompiledLayout::compile(defs);
+        assert(layout->size() == defs.size());
+        assert(layout->slotCount() == 3);
+
+        autolayout::View direct, first, second;
+        for(auto& c : defs)
+            direct.addConstraint(c);
+        first.instantiate(*layout);
+
+        std::vector<autolayout::ViewConstraint> collected;
+        second.instantiate(*layout, &collected);
+        assert(collected.size() == defs.size());
+
+        for(auto* v : {&direct, &first, &second})
+        {
+            v->setSize(500, 300);
+            v->update();
+        }
+
+        auto* b = first.getSubViews().at("b");
+        assert(abs(b->left() - 254) < 1e-6 && abs(b->width() - 238) < 1e-6 && abs(b->height() - 284) < 1e-6);
+        assert(sameFrames(direct, first));
+        assert(sameFrames(direct, second));
+    }
+
+    void batch()
+    {
+        auto defs = parse("H:|-[a]-[b(a)]-[c(>=20)]-| V:|-[a]-| V:|-[b]-| V:|-[c]-|"s);
+        auto extra = parse("C:c.w(40)"s);
+
+        autolayout::View direct, batched;
+        for(auto& c : defs)
+            direct.addConstraint(c);
+
+        batched.beginBatch();
+        for(auto& c : defs)
+            batched.addConstraint(c);
+
+        std::vector<autolayout::ViewConstraint> section;
+        for(auto& c : extra)
+            section.push_back(batched.addConstraint(c));
+        for(auto& c : section)
+            batched.removeConstraint(c);
+        assert(batched.inBatch());
+        batched.commit();
+        assert(!batched.inBatch());
+
+        for(auto* v : {&direct, &batched})
+        {
+            v->setSize(500, 300);
+            v->update();
+        }
+        assert(sameFrames(direct, batched));
+
+        batched.beginBatch();
+        for(auto& c : section)
+            batched.addConstraint(c);
+        batched.commit();
+        batched.update();
+        assert(!sameFrames(direct, batched));
+    }
+
+    // failures come back as a Status and leave the view as it was
+    void statuses()
+    {
+        using namespace autolayout;
+        auto const width = [](const char* view, double value){ return ConstraintDef(view, ATTR_WIDTH, REL_EQU, "", ATTR_CONST, 1, value, 1000); };
+
+        View view;
+        auto const a = view.addConstraint(width("a", 100));
+        assert(a.status() == STATUS_OK);
+        assert(view.addConstraint(a).status() == STATUS_DUPLICATE_CONSTRAINT);
+
+        assert(view.removeConstraint(view.addConstraint(width("a", 200))) == STATUS_OK);
+        assert(view.removeConstraint(a) == STATUS_OK && view.removeConstraint(a) == STATUS_UNKNOWN_CONSTRAINT);
+        assert(view.addConstraint(a).status() == STATUS_OK);
+        assert(view.addConstraint(ConstraintDef("a", ATTR_LEFT, REL_EQU, "-", ATTR_CENTERX)).status() == STATUS_INVALID_ARGUMENT);
+        assert(view.addConstraints({ width("b", 50), ConstraintDef("b", ATTR_LEFT, REL_EQU, "-", ATTR_CENTERX) }) == STATUS_INVALID_ARGUMENT);
+
+        view.beginBatch();
+        assert(view.step(0).status == STATUS_INVALID_STATE);
+        view.commit();
+
+        view.update();
+        assert(abs(view.getSubViews().at("a")->width() - 100) < 1e-6);
+
+        uint32_t const params[] = { 99, 0 };
+        double const values[] = { 10 };
+        assert(view.solveRows(params, 1, values, 1, (double*)nullptr).status == STATUS_OUT_OF_RANGE);
+        assert(view.setHierarchical(true) == STATUS_INVALID_STATE && !view.isHierarchical());
+        assert(view.addVariant("", {}) == STATUS_INVALID_ARGUMENT && view.setVariant("none") == STATUS_OUT_OF_RANGE);
+        assert(status_str(STATUS_UNKNOWN_CONSTRAINT) == "unknown constraint"s);
+
+        // View priorities stop short of required; the solver's own required constraints can conflict
+        SolverSet solver;
+        auto const x = solver.variables().create(), y = solver.variables().create();
+        Constraint const positive = y >= 0, three = x == 3;
+        assert(solver.addConstraint(x == 1) == STATUS_OK && solver.addConstraint(x == 2) == STATUS_UNSATISFIABLE_CONSTRAINT);
+        assert(solver.addConstraints({ positive, three }) == STATUS_UNSATISFIABLE_CONSTRAINT);
+        assert(solver.hasConstraint(positive) && !solver.hasConstraint(three));
+
+        // a swap (a variant's) with a required constraint that can't go in leaves every component as it was, whether
+        // the tableau pivots the removals out or is rebuilt without them
+        auto z = std::vector<Variable>{};
+        auto floors = std::vector<Constraint>{}, all = std::vector<Constraint>{};
+        for(int i=0; i<8; i++)
+        {
+            z.push_back(solver.variables().create());
+            floors.push_back(z.back() >= i);
+            all.push_back(floors.back());
+            all.push_back(z.back() <= x + i);
+            assert(solver.addConstraint(all[all.size() - 2]) == STATUS_OK && solver.addConstraint(all.back()) == STATUS_OK);
+        }
+        Constraint const two = x == 2, capped = y <= 5;
+        for(auto const& removed : { std::vector<Constraint>{ floors[0] }, all })
+        {
+            assert(solver.replaceConstraints(removed, { capped, two, z[1] >= 1.5 }) == STATUS_UNSATISFIABLE_CONSTRAINT);
+            assert(!solver.hasConstraint(capped) && !solver.hasConstraint(two));
+            for(auto const& cn : all)
+                assert(solver.hasConstraint(cn));
+            solver.updateVariables();
+            assert(solver.value(x) == 1 && solver.value(z[0]) >= 0 && solver.value(z[7]) >= 7 - 1e-9);
+        }
+        assert(solver.replaceConstraints({ floors[0] }, { capped }) == STATUS_OK);
+        assert(!solver.hasConstraint(floors[0]) && solver.hasConstraint(capped));
+    }
+
+    void handles()
+    {
+        autolayout::HandleRegistry registry;
+        auto const defs = registry.add(std::make_unique<std::vector<autolayout::ConstraintDef>>(parse("H:|-[a]-|"s)));
+        assert(registry.get<std::vector<autolayout::ConstraintDef>>(defs)->size() == 2);
+        assert(!registry.get<std::vector<autolayout::GridDef>>(defs) && !registry.get<std::vector<autolayout::ConstraintDef>>(defs + 1));
+        assert(registry.stats().live == 1 && registry.stats().bytes >= 2 * sizeof(autolayout::ConstraintDef));
+
+        // an arena releases what was added in it, nested ones first
+        assert(registry.beginArena() == 1);
+        auto const outer = registry.add(std::make_unique<std::vector<autolayout::GridDef>>(1));
+        assert(registry.beginArena() == 2);
+        auto const inner = registry.add(std::make_unique<std::vector<autolayout::GridDef>>(3));
+        auto const released = registry.add(std::make_unique<std::vector<autolayout::GridDef>>(2));
+        assert(registry.release(released) && !registry.release(released));
+        assert(registry.endArena() == 1 && !registry.get<std::vector<autolayout::GridDef>>(inner));
+        assert(registry.get<std::vector<autolayout::GridDef>>(outer) && registry.stats().live == 2);
+        assert(registry.endArena() == 1 && registry.endArena() == 0);
+
+        assert(registry.release(defs));
+        auto const& stats = registry.stats();
+        assert(stats.live == 0 && stats.bytes == 0 && stats.added == 4 && stats.released == 4);
+
+        // a released handle stays dead, even where the next object of its type lands at the same address
+        auto const def = registry.add(std::make_unique<autolayout::ConstraintDef>(parse("H:[a(10)]"s).at(0)));
+        registry.release(def);
+        auto const next = registry.add(std::make_unique<autolayout::ConstraintDef>(parse("H:[b(20)]"s).at(0)));
+        assert(next != def && !registry.get<autolayout::ConstraintDef>(def) && registry.get<autolayout::ConstraintDef>(next)->view1 == "b");
+
+        // a parse result's handle gives its defs one at a time, as raw_addConstraint takes them
+        auto const parsed = registry.add(std::make_unique<std::vector<autolayout::ConstraintDef>>(parse("H:|-[a]-[b(30)]-|"s)));
+        autolayout::View fromHandle;
+        fromHandle.setSize(200, 100);
+        for(size_t i=0; auto* con = registry.element<autolayout::ConstraintDef>(parsed, i); i++)
+            assert(fromHandle.addConstraint(*con).status() == autolayout::STATUS_OK);
+        fromHandle.update();
+        assert(abs(fromHandle.getSubViews().at("b")->width() - 30) < 1e-6);
+        assert(abs(fromHandle.getSubViews().at("a")->width() - (200 - 3 * 8 - 30)) < 1e-6);
+        auto const count = registry.get<std::vector<autolayout::ConstraintDef>>(parsed)->size();
+        assert(!registry.element<autolayout::ConstraintDef>(parsed, count) && !registry.element<autolayout::ConstraintDef>(next, 0));
+        registry.release(parsed);
+        assert(!registry.element<autolayout::ConstraintDef>(parsed, 0));
+
+        // and a binding given one has no constraint to hand on
+        autolayout::View view;
+        auto const none = autolayout::ViewConstraint(autolayout::STATUS_INVALID_ARGUMENT);
+        assert(view.addConstraint(none).status() == autolayout::STATUS_INVALID_ARGUMENT);
+        assert(view.removeConstraint(none) == autolayout::STATUS_UNKNOWN_CONSTRAINT);
+    }
+
+    void arena()
+    {
+        autolayout::Arena arena;
+        auto* a = arena.allocate(24);
+        auto* b = arena.allocate(100);
+        assert(arena.stats().chunks == 1 && arena.stats().used == 32 + 128);
+        arena.deallocate(a, 24);
+        assert(arena.allocate(20) == a && arena.stats().recycled == 1);     // same class: the freed block
+        arena.deallocate(b, 100);
+        auto* big = arena.allocate(1 << 20);                                // above the classes: the heap
+        arena.deallocate(big, 1 << 20);
+        assert(arena.stats().allocations == 3);
+
+        auto const defs = parse("H:|-[a]-[b(a)]-[c(>=40)]-| V:|-[a(b)]-[b]-| V:|-[c(50%)]-(>=8)-|"s);
+        autolayout::View heap, view;
+        assert(view.setArena(true) == autolayout::STATUS_OK && view.hasArena() && !heap.hasArena());
+        for(auto* v : {&heap, &view})
+        {
+            v->addConstraints(defs);
+            v->setSize(400, 300);
+            v->update();
+        }
+        assert(sameFrames(heap, view));
+        assert(view.setArena(false) == autolayout::STATUS_INVALID_STATE && view.hasArena());
+        assert(heap.setArena(true) == autolayout::STATUS_INVALID_STATE && heap.arenaStats().allocations == 0);
+
+        // a reset's re-layout reuses the blocks the last one freed
+        auto const loaded = view.arenaStats();
+        assert(loaded.allocations > 0 && loaded.used > 0);
+        view.reset();
+        std::vector<autolayout::ViewConstraint> collected;
+        view.addConstraints(defs, &collected);
+        view.setSize(400, 300);
+        view.update();
+        assert(sameFrames(heap, view));
+        auto const reloaded = view.arenaStats();
+        assert(reloaded.chunks == loaded.chunks && reloaded.recycled > loaded.recycled);
+
+        // removals give theirs back
+        for(auto& c : collected)
+            assert(view.removeConstraint(c) == autolayout::STATUS_OK);
+        assert(view.arenaStats().used < reloaded.used);
+
+        // not inside a batch or a suggest, which switching would drop; a cache's own suggest carries over
+        autolayout::View open, cached;
+        open.beginBatch();
+        assert(open.setArena(true) == autolayout::STATUS_INVALID_STATE);
+        open.commit();
+        open.beginSuggest();
+        assert(open.setArena(true) == autolayout::STATUS_INVALID_STATE && !open.hasArena());
+        open.endSuggest();
+        cached.enableCache(1 << 20);
+        assert(cached.setArena(true) == autolayout::STATUS_OK);
+        cached.beginSuggest();
+        assert(cached.setArena(false) == autolayout::STATUS_INVALID_STATE);
+        cached.endSuggest();
+        cached.addConstraints(defs);
+        for(double width : { 400, 500, 400 })
+        {
+            cached.setSize(width, 300);
+            cached.update();
+        }
+        assert(sameFrames(heap, cached) && cached.cacheStats().hits == 1);
+        cached.enableCache(0);
+        for(auto* v : {&heap, &cached})
+        {
+            v->setSize(500, 300);
+            v->update();
+        }
+        assert(sameFrames(heap, cached));
+
+        // a solver's edit variables move over with their suggestions
+        autolayout::SolverSet solver;
+        auto const x = solver.variables().create(), y = solver.variables().create();
+        solver.addEditVariable(x, kiwi::strength::strong);
+        solver.suggestValue(x, 7);
+        assert(solver.addConstraint(y == x + 1) == autolayout::STATUS_OK);
+        solver.setArena(&arena);
+        solver.updateVariables();
+        assert(solver.hasEditVariable(x) && solver.value(y) == 8);
+        solver.suggestValue(x, 10);
+        solver.updateVariables();
+        assert(solver.value(y) == 11);
+    }
+
+    void recycledSubViews()
+    {
+        auto const defs = parse("H:|-[a]-[b(a)]-[c(>=40)]-| V:|-[a(b)]-[b]-| V:|-[c(50%)]-(>=8)-|"s);
+        autolayout::View fresh, view;
+        for(auto* v : {&fresh, &view})
+        {
+            v->addConstraints(defs);
+            v->setSize(400, 300);
+            v->update();
+        }
+        auto* a = view.getSubViews().at("a");
+        auto* b = view.getSubViews().at("b");
+        auto* c = view.getSubViews().at("c");
+
+        // the same names get the same subviews back, laid out as if new
+        view.reset();
+        assert(view.subViewCount() == 0 && view.getSubViews().empty());
+        view.setSpacing(12);
+        fresh.setSpacing(12);
+        view.addConstraints(defs);
+        view.setSize(400, 300);
+        view.update();
+        fresh.update();
+        assert(view.getSubViews().at("a") == a && view.getSubViews().at("b") == b && view.getSubViews().at("c") == c);
+        assert(sameFrames(fresh, view) && view.getSubViews().at("c")->right() == fresh.getSubViews().at("c")->right());
+
+        // other names take what is left, renamed
+        auto const others = parse("H:|-[x(>=20)]-[a(100)]-| V:|-[x]-|"s);
+        autolayout::View other;
+        other.setSpacing(12);
+        view.reset();
+        for(auto* v : {&other, &view})
+        {
+            v->addConstraints(others);
+            v->setSize(400, 300);
+            v->update();
+        }
+        auto* x = view.getSubViews().at("x");
+        assert(x->name() == "x" && view.subViewCount() == 2 && sameFrames(other, view));
+        assert(x == a || x == b || x == c);
+    }
+
+    void compaction()
+    {
+        auto const defs = parse("H:|-[a(>=40)]-[b(a)]-[c(>=a)]-(>=8)-| V:|-[a(b)]-[b(>=30)]-(>=8)-| V:|-[c(50%)]-(>=8)-|"s);
+        auto const toggled = parse("H:[a(>=90@500)] H:[c(<=60@600)] V:[b(>=44@700)]"s);
+        autolayout::View fresh, view;
+        view.setAutoCompact(0);
+        for(auto* v : {&fresh, &view})
+        {
+            v->addConstraints(defs);
+            v->setSize(400, 300);
+            v->update();
+        }
+
+        // add/remove churn leaves the symbols of every constraint that came and went behind
+        auto const start = view.memoryBytes();
+        for(int i=0; i<300; i++)
+        {
+            std::vector<autolayout::ViewConstraint> collected;
+            view.addConstraints(toggled, &collected);
+            view.setSize(400 + i % 3, 300);
+            view.update();
+            for(auto& c : collected)
+                view.removeConstraint(c);
+        }
+        view.setSize(400, 300);
+        view.update();
+        assert(sameFrames(fresh, view));
+        auto const churned = view.memoryBytes();
+        assert(churned > start);
+
+        // the same values after, and the tableau works on from there
+        auto* a = view.getSubViews().at("a");
+        auto const left = a->left(), width = a->width();
+        auto const reclaimed = view.compact();
+        assert(reclaimed > 0 && view.memoryBytes() < churned && view.memoryBytes() <= start + start / 2);
+        view.update();
+        assert(a->left() == left && a->width() == width && sameFrames(fresh, view));
+        assert(view.compact() == 0);
+
+        for(auto* v : {&fresh, &view})
+        {
+            v->setSize(520, 410);
+            v->update();
+        }
+        assert(sameFrames(fresh, view));
+        std::vector<autolayout::ViewConstraint> collected;
+        view.addConstraints(toggled, &collected);
+        fresh.addConstraints(toggled);
+        for(auto* v : {&fresh, &view})
+            v->update();
+        assert(sameFrames(fresh, view));
+        for(auto& c : collected)
+            assert(view.removeConstraint(c) == autolayout::STATUS_OK);
+
+        // automatically, removals keep it bounded
+        autolayout::View automatic;
+        automatic.addConstraints(defs);
+        automatic.setSize(400, 300);
+        automatic.update();
+        auto peak = size_t{0};
+        for(int i=0; i<600; i++)
+        {
+            std::vector<autolayout::ViewConstraint> collected;
+            automatic.addConstraints(toggled, &collected);
+            automatic.update();
+            for(auto& c : collected)
+                automatic.removeConstraint(c);
+            peak = std::max(peak, automatic.memoryBytes());
+        }
+        automatic.update();
+        view.setSize(400, 300);
+        view.update();
+        assert(automatic.autoCompacted() > 0 && peak < churned && sameFrames(view, automatic));
+    }
+
+    void variables()
+    {
+        using namespace autolayout;
+
+        // released slots go to the next create(), zeroed; creating one into a warm table doesn't allocate (checked
+        // where the build counts allocations)
+        SolverSet solver;
+        auto& table = solver.variables();
+        auto const x = table.create(), y = table.create(), z = table.create();
+        assert(x.id == 0 && y.id == 1 && z.id == 2 && table.live() == 3);
+        table.setValue(z, 5);
+        table.release(z);
+        auto const allocations = heapAllocations;
+        auto const w = table.create();
+        assert(heapAllocations == allocations && w.id == z.id && table.value(w) == 0 && table.size() == 3);
+
+        // terms sum per variable, in variable order
+        auto const cn = Constraint(y + x * 2 - x == 3 - y);
+        assert(cn.op() == OP_EQ && cn.expression().terms().size() == 2 && cn.expression().constant() == -3);
+        assert(cn.expression().terms()[0].variable().id == x.id && cn.expression().terms()[0].coefficient() == 1);
+        assert(cn.expression().terms()[1].variable().id == y.id && cn.expression().terms()[1].coefficient() == 2);
+        assert(!Constraint() && !(cn < cn) && Constraint(cn, kiwi::strength::weak).strength() == kiwi::strength::weak);
+
+        // the solvers write values straight into the table's array
+        assert(solver.addConstraint(x == 3) == STATUS_OK && solver.addConstraint(cn) == STATUS_OK);
+        solver.updateVariables();
+        assert(table.values()[x.id] == 3 && table.values()[y.id] == 0 && solver.value(x) == 3);
+
+        // reset() hands the variables of subviews the new layout doesn't name back for the next one
+        View view;
+        auto const first = parse("H:|-[a]-[b]-| V:|-[a]-| V:|-[b]-|"s), second = parse("H:|-[c]-[d]-[e]-| V:|-[c]-| V:|-[e]-|"s);
+        auto size = size_t{0};
+        for(int round=0; round<6; round++)
+        {
+            view.reset();
+            view.addConstraints(round % 2 ? second : first);
+            view.setSize(400, 300);
+            view.update();
+            if(round == 2)
+                size = view.variables().size();
+        }
+        assert(view.variables().size() == size);
+        auto const& right = view.getSubViews().at("e")->variable(ATTR_RIGHT);
+        assert(right && abs(view.variables().values()[right->id] - 392) < 1e-6);
+    }
+
+    void bulkLoad()
+    {
+        auto defs = parse("H:|-[a]-[b(a)]-[c(a)]-| V:|-[a]-| V:|-[b]-| V:|-[c]-|"s);
+
+        autolayout::View incremental, bulk;
+        for(auto& c : defs)
+            incremental.addConstraint(c);
+
+        std::vector<autolayout::ViewConstraint> collected;
+        bulk.addConstraints(defs, &collected);
+        assert(collected.size() == defs.size());
+
+        for(auto* v : {&incremental, &bulk})
+        {
+            v->setSize(500, 300);
+            v->update();
+        }
+        assert(sameFrames(incremental, bulk));
+
+        for(auto& c : collected)
+            bulk.removeConstraint(c);
+        bulk.addConstraints(defs);
+        bulk.update();
+        assert(sameFrames(incremental, bulk));
+    }
+
+    void batchedSuggest()
+    {
+        auto defs = parse("H:|-[a]-[b]-[c]-| V:|-[a]-| V:|-[b]-| V:|-[c]-|"s);
+
+        autolayout::View single, batched;
+        for(auto* v : {&single, &batched})
+        {
+            v->addConstraints(defs);
+            v->setSize(500, 300);
+        }
+
+        auto measure = [](autolayout::View& v, double w)
+        {
+            auto& svs = v.getSubViews();
+            svs.at("a")->setIntrinsicWidth(w);
+            svs.at("b")->setIntrinsicWidth(w * 2);
+            svs.at("b")->setIntrinsicHeight(w);
+        };
+
+        for(auto w : {50.0, 80.0, 20.0})
+        {
+            measure(single, w);
+            single.setSpacing(w / 10);
+
+            batched.beginSuggest();
+            measure(batched, w);
+            batched.setSpacing(w / 10);
+            batched.endSuggest();
+
+            single.update();
+            batched.update();
+            assert(sameFrames(single, batched));
+        }
+
+        auto* b = batched.getSubViews().at("b");
+        assert(abs(b->width() - 40) < 1e-6 && abs(b->height() - 20) < 1e-6);
+    }
+
+    void intrinsicSizes()
+    {
+        auto defs = parse("H:|-[a]-[b]-[c]-| V:|-[a]-| V:|-[b]-| V:|-[c]-|"s);
+
+        autolayout::View single, records;
+        for(auto* v : {&single, &records})
+        {
+            v->addConstraints(defs);
+            v->setSize(500, 300);
+        }
+
+        auto a = records.indexOf("a"), b = records.indexOf("b");
+        assert(a >= 0 && b >= 0 && a != b && records.indexOf("nope") == -1);
+        assert(records.getSubView(b)->name() == "b" && records.subViewCount() == 3);
+
+        auto nan = std::numeric_limits<double>::quiet_NaN();
+        double sizes[] = { (double)a, 60, 40,  (double)b, 90, nan,  99, 10, 10 };
+        assert(records.setIntrinsicSizes(sizes, 3) == 2);
+
+        single.getSubViews().at("a")->setIntrinsicWidth(60);
+        single.getSubViews().at("a")->setIntrinsicHeight(40);
+        single.getSubViews().at("b")->setIntrinsicWidth(90);
+
+        single.update();
+        records.update();
+        assert(sameFrames(single, records));
+        assert(!records.getSubView(b)->intrinsicHeight());
+
+        double cleared[] = { (double)a, nan, nan };
+        records.setIntrinsicSizes(cleared, 1);
+        single.getSubViews().at("a")->setIntrinsicWidth(boost::none);
+        single.getSubViews().at("a")->setIntrinsicHeight(boost::none);
+
+        single.update();
+        records.update();
+        assert(sameFrames(single, records));
+        assert(!records.getSubView(a)->intrinsicWidth());
+    }
+
+    void frames()
+    {
+        autolayout::View view;
+        view.addConstraints(parse("H:|-[a]-[b(a)]-| V:|-[a]-| V:|-[b]-|"s));
+        view.setSize(500, 300);
+        view.update();
+
+        auto const* f = view.frames();
+        float f32[8];
+        view.writeFrames(f32);
+        for(size_t i=0; i<view.subViewCount(); i++)
+        {
+            auto* sv = view.getSubView(i);
+            assert(f[i*4] == sv->left() && f[i*4+1] == sv->top() && f[i*4+2] == sv->width() && f[i*4+3] == sv->height());
+            assert(f32[i*4+2] == (float)sv->width());
+        }
+
+        auto b = view.indexOf("b");
+        assert(abs(f[b*4] - 254) < 1e-6 && abs(f[b*4+2] - 238) < 1e-6);
+    }
+
+    void changed()
+    {
+        autolayout::View view;
+        view.addConstraints(parse("H:|-[a]-[b]-| V:|-[a]-| V:|-[b]-|"s));
+        view.getSubViews().at("a")->setIntrinsicWidth(100);
+        view.setSize(500, 300);
+        view.trackChanges(0.5);
+
+        view.update();
+        assert(view.changed().size() == 2);
+
+        view.update();
+        assert(view.changed().empty());
+
+        // a stays put, b stretches
+        view.setSize(600, 300);
+        view.update();
+        assert(view.changed().size() == 1 && view.changed()[0] == (uint32_t)view.indexOf("b"));
+
+        view.setSize(600.2, 300);
+        view.update();
+        assert(view.changed().empty());
+    }
+
+    void redundantSolves()
+    {
+        autolayout::View view;
+        view.addConstraints(parse("H:|-[a]-[b]-| V:|-[a]-| V:|-[b]-|"s));
+        view.setSize(500, 300);
+        assert(view.dirty());
+        view.update();
+        assert(!view.dirty());
+
+        auto before = view.stats();
+        view.setSize(500, 300);
+        view.setSpacing(8);
+        view.update();
+        auto after = view.stats();
+        assert(after.suggestions == before.suggestions && after.skippedSuggestions == before.skippedSuggestions + 2);
+        assert(after.updates == before.updates && after.skippedUpdates == before.skippedUpdates + 1);
+
+        view.getSubViews().at("a")->setIntrinsicWidth(100);
+        assert(view.dirty());
+        view.update();
+        assert(view.stats().updates == after.updates + 1);
+        assert(abs(view.getSubViews().at("a")->width() - 100) < 1e-6);
+    }
+
+    void staticLayout()
+    {
+        auto defs = parse("H:|-[a]-[b]-[c(b)]-| V:|-[a]-| V:|-[b]-| V:|-[c]-|"s);
+
+        autolayout::View dynamic, fixed(true);
+        assert(fixed.isStatic() && !dynamic.isStatic());
+
+        std::vector<autolayout::ViewConstraint> collected;
+        dynamic.addConstraints(defs);
+        fixed.addConstraints(defs, &collected);
+
+        auto apply = [](autolayout::View& v, double w, double spacing)
+        {
+            v.setSize(w, 300);
+            v.setSpacing(spacing);
+            v.getSubViews().at("a")->setIntrinsicWidth(w / 5);
+            v.update();
+        };
+
+        for(auto [w, spacing] : {std::pair{500.0, 8.0}, {600.0, 12.0}, {400.0, 12.0}})
+        {
+            apply(dynamic, w, spacing);
+            apply(fixed, w, spacing);
+            assert(sameFrames(dynamic, fixed));
+        }
+
+        // a folded constraint taken out and put back picks up the spacing in effect by then
+        for(auto& c : collected)
+            fixed.removeConstraint(c);
+        fixed.setSpacing(4);
+        for(auto& c : collected)
+            fixed.addConstraint(c);
+        dynamic.setSpacing(4);
+
+        dynamic.update();
+        fixed.update();
+        assert(sameFrames(dynamic, fixed));
+        assert(abs(fixed.getSubViews().at("a")->left() - 4) < 1e-6);
+
+        // ... also when it comes back in the batch that took it out, and respacing finds it either way
+        fixed.beginBatch();
+        fixed.removeConstraint(collected[0]);
+        fixed.addConstraint(collected[0]);
+        fixed.commit();
+        fixed.removeConstraint(collected[1]);
+        fixed.setSpacing(6);
+        fixed.addConstraint(collected[1]);
+        dynamic.setSpacing(6);
+        dynamic.update();
+        fixed.update();
+        assert(sameFrames(dynamic, fixed));
+        for(auto& c : collected)
+            assert(fixed.removeConstraint(c) == autolayout::STATUS_OK);
+        assert(fixed.removeConstraint(collected[0]) == autolayout::STATUS_UNKNOWN_CONSTRAINT);
+    }
+
+    void layoutCache()
+    {
+        auto defs = parse("H:|-[a]-[b(a)]-[c(a)]-| V:|-[a]-| V:|-[b]-| V:|-[c]-|"s);
+
+        autolayout::View plain, cached;
+        plain.addConstraints(defs);
+        cached.addConstraints(defs);
+        cached.enableCache(1 << 20);
+
+        for(auto w : {500.0, 800.0, 500.0, 640.0, 800.0})
+        {
+            for(auto* v : {&plain, &cached})
+            {
+                v->setSize(w, 300);
+                v->update();
+            }
+            assert(sameFrames(plain, cached));
+        }
+
+        auto stats = cached.cacheStats();
+        assert(stats.hits == 2 && stats.misses == 3 && stats.entries == 3);
+
+        // the constraint set is part of the key
+        cached.addConstraint(parse("C:a.w(40)"s)[0]);
+        plain.addConstraint(parse("C:a.w(40)"s)[0]);
+        for(auto* v : {&plain, &cached})
+        {
+            v->setSize(500, 300);
+            v->update();
+        }
+        assert(sameFrames(plain, cached));
+        assert(cached.cacheStats().hits == 2);
+
+        // a cap of one entry's worth evicts the older ones
+        cached.enableCache(cached.cacheStats().bytes / cached.cacheStats().entries);
+        assert(cached.cacheStats().entries == 1 && cached.cacheStats().evictions == 3);
+    }
+
+    void sweep()
+    {
+        auto defs = parse("H:|-[a]-[b(a)]-| V:|-[a]-| V:|-[b]-|"s);
+
+        autolayout::View view, each;
+        view.addConstraints(defs);
+        each.addConstraints(defs);
+        view.setSize(500, 300);
+        view.update();
+
+        double sizes[] = { 300, 200,  400, 200,  600, 500 };
+        auto const* out = view.sweep(sizes, 3);
+        auto const stride = view.subViewCount() * 4;
+
+        for(int i=0; i<3; i++)
+        {
+            each.setSize(sizes[i * 2], sizes[i * 2 + 1]);
+            each.update();
+            auto const* f = each.frames();
+            for(size_t k=0; k<stride; k++)
+                assert(abs(out[i * stride + k] - f[k]) < 1e-6);
+        }
+
+        // back at its own size
+        assert(abs(view.getSubViews().at("b")->left() - 254) < 1e-6);
+
+        // changed() is against the frames the last update() gave, not the sizes swept: a changed, b is back
+        autolayout::View tracked;
+        tracked.addConstraints(parse("H:|-[a] H:|-[b]-| V:|-[a(20)]-[b]-|"s));
+        tracked.setSize(500, 300);
+        tracked.getSubViews().at("a")->setIntrinsicWidth(50);
+        tracked.trackChanges(0.5);
+        tracked.update();
+        tracked.getSubViews().at("a")->setIntrinsicWidth(200);
+        double const wide[] = { 600, 300 };
+        tracked.sweep(wide, 1);
+        assert(abs(tracked.getSubViews().at("a")->width() - 200) < 1e-6);
+        assert(tracked.changed() == std::vector<uint32_t>{ (uint32_t)tracked.indexOf("a") });
+        tracked.update();
+        assert(tracked.changed().empty());
+    }
+
+    void solveRows()
+    {
+        auto defs = parse("H:|-[icon(40)]-[title]-(>=8)-| H:[icon]-[body]-| V:|-[icon(40)] V:|-[title(20)]-[body]-(>=8)-|"s);
+
+        autolayout::View view, each;
+        view.addConstraints(defs);
+        each.addConstraints(defs);
+        for(auto* v : {&view, &each})
+        {
+            v->setSize(320, 200);
+            v->getSubViews().at("body")->setIntrinsicHeight(40);
+            v->update();
+        }
+
+        // title width and body height per row; 170 runs into the bottom margin and needs a solve
+        uint32_t const params[] = { (uint32_t)view.indexOf("title"), 0,  (uint32_t)view.indexOf("body"), 1 };
+        double const values[] = { 200, 50,  180, 70,  200, 170,  220, 60,  200, 30 };
+        auto const stride = view.subViewCount() * 4;
+        std::vector<double> out(5 * stride);
+        view.trackChanges(0.5);
+        view.update();
+        auto const solved = view.solveRows(params, 2, values, 5, out.data()).value;
+        assert(solved >= 2 && solved < 5);
+        assert(view.changed().empty());
+
+        for(int i=0; i<5; i++)
+        {
+            each.getSubViews().at("title")->setIntrinsicWidth(values[i * 2]);
+            each.getSubViews().at("body")->setIntrinsicHeight(values[i * 2 + 1]);
+            each.update();
+            auto const* f = each.frames();
+            for(size_t k=0; k<stride; k++)
+                assert(abs(out[i * stride + k] - f[k]) < 1e-6);
+        }
+
+        // own intrinsic sizes back
+        assert(!view.getSubViews().at("title")->intrinsicWidth());
+        assert(abs(view.getSubViews().at("body")->height() - 40) < 1e-6);
+
+        // a subview's size named twice would make a basis with the same edit twice
+        uint32_t const twice[] = { params[0], 0,  params[0], 0 };
+        assert(view.solveRows(twice, 2, values, 1, out.data()).status == autolayout::STATUS_INVALID_ARGUMENT);
+        uint32_t const both[] = { params[0], 0,  params[0], 1 };
+        assert(view.solveRows(both, 2, values, 1, out.data()).ok());
+    }
+
+    void variants()
+    {
+        auto const phone = parse("V:|-[a]-[b(a)]-| H:|-[a]-| H:|-[b]-|"s);
+        auto const tablet = parse("H:|-[a]-[b(a)]-| V:|-[a]-| V:|-[b]-|"s);
+
+        autolayout::View view, expectPhone, expectTablet;
+        view.addVariant("phone", phone);
+        view.addVariant("tablet", tablet);
+        expectPhone.addConstraints(phone);
+        expectTablet.addConstraints(tablet);
+
+        auto check = [&](const char* variant, double w, autolayout::View& expected)
+        {
+            view.setVariant(variant);
+            view.setSize(w, 400);
+            view.update();
+            expected.setSize(w, 400);
+            expected.update();
+            assert(view.variant() == variant && sameFrames(expected, view));
+        };
+
+        check("phone", 300, expectPhone);
+        check("tablet", 300, expectTablet);
+        check("phone", 300, expectPhone);
+        assert(view.variantStats().restored == 1 && view.variantStats().applied == 2);
+
+        // a restored variant still solves once something changes
+        check("phone", 320, expectPhone);
+        check("tablet", 320, expectTablet);
+        check("phone", 320, expectPhone);
+        assert(view.variantStats().switches == 5 && view.variantStats().restored == 2);
+
+        // constraints outside the variants apply too, and outdate the values kept
+        auto const shared = parse("V:[a(b*0.5@750)]"s);
+        view.addConstraint(shared[0]);
+        expectPhone.addConstraint(shared[0]);
+        check("phone", 320, expectPhone);
+        assert(view.variantStats().restored == 2 && abs(view.getSubViews().at("a")->height() * 2 - view.getSubViews().at("b")->height()) < 1e-6);
+    }
+
+    void components()
+    {
+        auto defs = parse("H:|-[a(40)]-[b]-| V:|-[a]-| V:|-[b(20)]-(>=8)-|"s);
+
+        autolayout::View view;
+        view.addConstraints(defs);
+        view.setSize(500, 300);
+        view.update();
+        assert(view.componentCount() == 2);
+
+        auto* b = view.getSubViews().at("b");
+        assert(abs(b->left() - 56) < 1e-6 && abs(b->width() - 436) < 1e-6 && abs(b->height() - 20) < 1e-6);
+
+        // only the horizontal tableau re-solves for a width
+        auto before = view.stats();
+        view.setSize(600, 300);
+        view.update();
+        assert(view.stats().suggestions == before.suggestions + 1);
+        assert(abs(b->width() - 536) < 1e-6);
+
+        // a constraint across the axes joins them
+        view.addConstraint(autolayout::ConstraintDef("b", autolayout::ATTR_HEIGHT, autolayout::REL_EQU, "a", autolayout::ATTR_WIDTH, 0.5, 0, 1000));
+        view.update();
+        assert(view.componentCount() == 1);
+        assert(abs(b->height() - 20) < 1e-6 && abs(b->width() - 536) < 1e-6);
+    }
+
+    void hierarchy()
+    {
+        auto defs = parse("H:|-[g:-[a(40)]-[b]-]-[x(30)]-| V:|-[g:-[a,b]-]-| V:|-[x]-|"s);
+        assert(defs[0].container.empty() && std::count_if(defs.begin(), defs.end(), [](auto const& def){ return def.container == "g"; }) > 0);
+
+        autolayout::View flat, view;
+        view.setHierarchical(true);
+        for(auto* v : { &flat, &view })
+        {
+            v->addConstraints(defs);
+            v->setSize(500, 300);
+            v->update();
+        }
+        assert(view.componentCount() > flat.componentCount());
+
+        // same frames, children placed in their container
+        auto* b = view.getSubViews().at("b");
+        assert(abs(b->left() - 64) < 1e-6 && abs(b->width() - 382) < 1e-6 && abs(b->top() - 16) < 1e-6 && abs(b->height() - 268) < 1e-6);
+        auto frames = std::vector<double>(flat.frames(), flat.frames() + 4 * flat.subViewCount());
+        for(size_t i=0; i<frames.size(); i++)
+            assert(abs(frames[i] - view.frames()[i]) < 1e-6);
+
+        // the container's new height reaches its children; its width didn't change
+        auto before = view.stats();
+        view.setSize(500, 400);
+        view.update();
+        assert(view.stats().suggestions == before.suggestions + 2);
+        assert(abs(b->height() - 368) < 1e-6 && abs(b->width() - 382) < 1e-6);
+
+        // a and x lie in different coordinate spaces
+        auto const cross = view.addConstraint(autolayout::ConstraintDef("a", autolayout::ATTR_WIDTH, autolayout::REL_EQU, "x", autolayout::ATTR_WIDTH));
+        assert(cross.status() == autolayout::STATUS_INVALID_ARGUMENT);
+    }
+
+    void closedForm()
+    {
+        auto defs = parse("H:|-[a(100)]-[b]-[c(50)]-| V:|-[a,b,c]-|"s);
+
+        autolayout::View view;
+        view.addConstraints(defs);
+        view.setSize(500, 300);
+        view.update();
+        auto const all = view.closedFormConstraints();
+        assert(all > defs.size());
+
+        auto* b = view.getSubViews().at("b");
+        auto* c = view.getSubViews().at("c");
+        assert(abs(b->left() - 116) < 1e-6 && abs(b->width() - 318) < 1e-6 && abs(c->left() - 442) < 1e-6 && abs(b->height() - 284) < 1e-6);
+
+        view.setSize(600, 400);
+        view.update();
+        assert(abs(b->width() - 418) < 1e-6 && abs(c->left() - 542) < 1e-6 && abs(b->height() - 384) < 1e-6);
+
+        // an inequality hands the horizontal constraints to the simplex; the vertical ones stay
+        view.addConstraint(autolayout::ConstraintDef("b", autolayout::ATTR_WIDTH, autolayout::REL_GEQ, "a", autolayout::ATTR_WIDTH));
+        view.update();
+        auto const vertical = view.closedFormConstraints();
+        assert(vertical > 0 && vertical < all);
+        assert(abs(b->width() - 418) < 1e-6 && abs(b->height() - 384) < 1e-6);
+
+        // so does a redundant equality
+        view.addConstraint(autolayout::ConstraintDef("a", autolayout::ATTR_TOP, autolayout::REL_EQU, "b", autolayout::ATTR_TOP));
+        view.update();
+        assert(view.closedFormConstraints() == 0);
+        assert(abs(b->top() - 8) < 1e-6 && abs(b->height() - 384) < 1e-6);
+    }
+
+    void grid()
+    {
+        auto grids = std::vector<ast::GridDef>{};
+        auto defs = parse("HV:|-[g]-| G:g(100,1fr,auto)(40,1fr)[a,b,c][d,d,.]"s, &grids);
+        assert(grids.size() == 1 && grids[0].columns.size() == 3 && grids[0].rows.size() == 2);
+        assert(grids[0].columns[2].sizing == autolayout::TRACK_AUTO && grids[0].rows[1].sizing == autolayout::TRACK_FR && grids[0].cells[1][2].empty());
+
+        autolayout::View view;
+        view.addGrid(grids[0]);
+        view.addConstraints(defs);
+        view.addConstraint(autolayout::ConstraintDef("x", autolayout::ATTR_LEFT, autolayout::REL_EQU, "b", autolayout::ATTR_LEFT));
+        view.addConstraint(autolayout::ConstraintDef("x", autolayout::ATTR_WIDTH, autolayout::REL_EQU, "c", autolayout::ATTR_WIDTH));
+        view.addConstraint(autolayout::ConstraintDef("x", autolayout::ATTR_TOP, autolayout::REL_EQU, "d", autolayout::ATTR_BOTTOM));
+        view.getSubViews().at("c")->setIntrinsicWidth(60);
+        view.setSize(500, 300);
+        view.update();
+
+        // columns 100, (484 - 100 - 60 - 2 * 8) and 60; rows 40 and the rest. d spans two columns.
+        auto* b = view.getSubViews().at("b");
+        auto* d = view.getSubViews().at("d");
+        auto* x = view.getSubViews().at("x");
+        assert(abs(b->left() - 116) < 1e-6 && abs(b->width() - 308) < 1e-6 && abs(b->top() - 8) < 1e-6 && abs(b->height() - 40) < 1e-6);
+        assert(abs(d->left() - 8) < 1e-6 && abs(d->width() - 416) < 1e-6 && abs(d->top() - 56) < 1e-6 && abs(d->bottom() - 292) < 1e-6);
+
+        // constraints see the cells they name
+        assert(abs(x->left() - 116) < 1e-6 && abs(x->width() - 60) < 1e-6 && abs(x->top() - 292) < 1e-6);
+
+        // a cell's intrinsic size reaches its auto track without the solver
+        view.getSubViews().at("c")->setIntrinsicWidth(80);
+        assert(view.dirty());
+        view.update();
+        assert(abs(b->width() - 288) < 1e-6 && abs(x->width() - 80) < 1e-6);
+
+        view.setSize(600, 400);
+        view.update();
+        assert(abs(b->width() - 388) < 1e-6 && abs(d->bottom() - 392) < 1e-6 && abs(x->top() - 392) < 1e-6);
+
+        // spans have to be rectangles
+        grids.clear();
+        parse("G:h[p,q][q,p]"s, &grids);
+        assert(view.addGrid(grids[0]) == autolayout::STATUS_INVALID_ARGUMENT && view.gridCount() == 1);
+    }
+
+    void stepped()
+    {
+        auto src = "V:|"s;
+        for(int i=0; i<30; i++)
+        {
+            auto const k = std::to_string(i);
+            src += "-[a" + k + "(20),b" + k + "(20)]";
+        }
+        src += "-(>=8)-|";
+        for(int i=0; i<30; i++)
+        {
+            auto const k = std::to_string(i);
+            src += " H:|-[a" + k + "(>=20)]-[b" + k + "(100)]-|";
+        }
+        auto defs = parse(src);
+
+        autolayout::View direct, view;
+        direct.addConstraints(defs);
+        direct.setSize(500, 1000);
+        direct.update();
+
+        // nothing queued: done right away
+        view.setSize(500, 1000);
+        assert(view.step(0).value == autolayout::STEP_DONE && !view.loading());
+
+        // no budget: a chunk or a round of pivots per call
+        view.queueConstraints(defs);
+        assert(view.loading());
+        auto steps = 0;
+        while(view.step(0).value == autolayout::STEP_MORE)
+        {
+            assert(view.loading());
+            if(++steps == 3)
+                view.update();
+        }
+        assert(steps > 3 && !view.loading());
+        assert(sameFrames(direct, view));
+
+        // a later queue goes on from the solved layout
+        auto more = parse("H:|-[c(>=30)]-| V:|-[c(40)]-(>=8)-|"s);
+        direct.addConstraints(more);
+        direct.update();
+        view.queueConstraints(more);
+        while(view.step(1e6).value == autolayout::STEP_MORE);
+        assert(sameFrames(direct, view) && abs(view.getSubViews().at("c")->height() - 40) < 1e-6);
+    }
+
+    // a view reset() is as good as new: the root's origin and right/bottom hold the next layout too
+    void resetRoot()
+    {
+        auto const defs = parse("H:|-[a]-| V:|-[a(40)]"s);
+        autolayout::View fresh, reused;
+        reused.addConstraints(parse("H:|-[b(30)]-| V:|-[b]-|"s));
+        reused.setSize(200, 100);
+        reused.update();
+        reused.reset();
+
+        for(auto* v : {&fresh, &reused})
+        {
+            v->addConstraints(defs);
+            v->setSize(300, 200);
+            v->update();
+        }
+        assert(sameFrames(fresh, reused));
+        auto* a = reused.getSubViews().at("a");
+        assert(abs(a->left() - 8) < 1e-6 && abs(a->right() - 292) < 1e-6 && abs(a->top() - 8) < 1e-6);
+    }
+
     void all()
     {
         multiplier();
@@ -308,16 +1386,557 @@ namespace evfl::test
         extendedVisualFormat();
 
         mevfl();
+        compiledLayout();
+        batch();
+        statuses();
+        handles();
+        arena();
+        recycledSubViews();
+        compaction();
+        variables();
+        bulkLoad();
+        batchedSuggest();
+        intrinsicSizes();
+        frames();
+        changed();
+        redundantSolves();
+        staticLayout();
+        layoutCache();
+        sweep();
+        solveRows();
+        variants();
+        components();
+        hierarchy();
+        closedForm();
+        grid();
+        stepped();
+        resetRoot();
     }
 };
 
-int main()
+namespace evfl::bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    double ms(Clock::time_point since) { return std::chrono::duration<double, std::milli>(Clock::now() - since).count(); }
+
+    // ", n heap allocations" per one of runs since the count was since; nothing unless the build counts them
+    std::string allocated(uint64_t since, uint64_t runs, const char* per = "")
+    {
+#ifdef AUTOLAYOUT_COUNT_ALLOCATIONS
+        return ", " + std::to_string((heapAllocations - since) / runs) + " heap allocations" + per;
+#else
+        (void)since, (void)runs, (void)per;
+        return "";
+#endif
+    }
+
+    // rows of `cols` views chained horizontally, every column chained vertically
+    std::string grid(int rows, int cols)
+    {
+        auto out = std::string{};
+        for(int r=0; r<rows; r++)
+        {
+            out += "H:|";
+            for(int c=0; c<cols; c++)
+                out += "-[r" + std::to_string(r) + "c" + std::to_string(c) + "]";
+            out += "-|\n";
+        }
+
+        for(int c=0; c<cols; c++)
+        {
+            out += "V:|";
+            for(int r=0; r<rows; r++)
+                out += "-[r" + std::to_string(r) + "c" + std::to_string(c) + "]";
+            out += "-|\n";
+        }
+        return out;
+    }
+
+    void bulkLoad()
+    {
+        for(auto rows : {5, 50, 500, 2500})
+        {
+            auto defs = evfl::test::parse(grid(rows, 10));
+
+            auto start = Clock::now();
+            {
+                autolayout::View view;
+                view.addConstraints(defs);
+                view.setSize(1000, 1000);
+                view.update();
+            }
+            auto bulk = ms(start);
+            std::cout << defs.size() << " constraints: bulk " << bulk << "ms";
+
+            // one at a time is quadratic in the chain length; minutes at the largest size
+            if(rows <= 500)
+            {
+                start = Clock::now();
+                {
+                    autolayout::View view;
+                    for(auto& c : defs)
+                        view.addConstraint(c);
+                    view.setSize(1000, 1000);
+                    view.update();
+                }
+                std::cout << ", incremental " << ms(start) << "ms";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    // every subview re-measured: one dual optimization per suggestion vs one for the whole set
+    void batchedSuggest()
+    {
+        auto defs = evfl::test::parse(grid(100, 10));
+        autolayout::View view;
+        view.addConstraints(defs);
+        view.setSize(1000, 1000);
+
+        auto subViews = std::vector<autolayout::SubView*>{};
+        for(auto& kv : view.getSubViews())
+            subViews.push_back(kv.second);
+        for(auto* sv : subViews)
+            sv->setIntrinsicWidth(10);
+
+        auto start = Clock::now();
+        for(auto* sv : subViews)
+            sv->setIntrinsicWidth(20);
+        view.update();
+        auto single = ms(start);
+
+        start = Clock::now();
+        view.beginSuggest();
+        for(auto* sv : subViews)
+            sv->setIntrinsicWidth(30);
+        view.endSuggest();
+        view.update();
+        auto batched = ms(start);
+
+        std::cout << subViews.size() << " intrinsic widths: one by one " << single << "ms, batched " << batched << "ms" << std::endl;
+    }
+
+    // one subview re-measured: update() writes back only the variables whose rows changed
+    void smallUpdate()
+    {
+        autolayout::View view;
+        view.addConstraints(evfl::test::parse(grid(500, 10)));
+        view.setSize(1000, 1000);
+        view.update();
+
+        auto* sv = view.getSubView(view.subViewCount() - 1);
+        sv->setIntrinsicWidth(10);
+        view.update();
+
+        auto const n = 1000;
+        auto start = Clock::now();
+        for(int i=0; i<n; i++)
+        {
+            sv->setIntrinsicWidth(10 + i % 2);
+            view.update();
+        }
+        std::cout << "suggest + update, " << view.subViewCount() << " subviews: " << ms(start) / n << "ms" << std::endl;
+    }
+
+    // list cells of varying body heights: solveRows evaluates most from one basis
+    void solveRows()
+    {
+        auto defs = evfl::test::parse("H:|-[icon(40)]-[title]-(>=8)-| H:[icon]-[body]-| V:|-[icon(40)] V:|-[title(20)]-[body]-(>=8)-|"s);
+        autolayout::View view, each;
+        for(auto* v : {&view, &each})
+        {
+            v->addConstraints(defs);
+            v->setSize(320, 200);
+            v->update();
+        }
+
+        auto const n = 10000;
+        uint32_t const params[] = { (uint32_t)view.indexOf("body"), 1 };
+        auto values = std::vector<double>(n);
+        for(int i=0; i<n; i++)
+            values[i] = 20 + (i * 37) % 200;
+        auto out = std::vector<double>(n * view.subViewCount() * 4);
+
+        auto start = Clock::now();
+        auto* body = each.getSubViews().at("body");
+        for(int i=0; i<n; i++)
+        {
+            body->setIntrinsicHeight(values[i]);
+            each.update();
+            each.writeFrames(out.data() + i * each.subViewCount() * 4);
+        }
+        auto one = ms(start);
+
+        start = Clock::now();
+        auto const solved = view.solveRows(params, 1, values.data(), n, out.data()).value;
+        std::cout << n << " rows: update each " << one << "ms, solveRows " << ms(start) << "ms (" << solved << " solved)" << std::endl;
+    }
+
+    // breakpoint crossings between two variants of the same subviews: reset and re-add, swap, restore
+    void variants()
+    {
+        auto wide = grid(50, 10), narrow = wide;
+        for(auto& ch : narrow)
+        {
+            if(ch == 'H')
+                ch = 'V';
+            else if(ch == 'V')
+                ch = 'H';
+        }
+        auto const wideDefs = evfl::test::parse(wide), narrowDefs = evfl::test::parse(narrow);
+
+        autolayout::View view;
+        auto start = Clock::now();
+        for(auto const* defs : {&narrowDefs, &wideDefs})
+        {
+            view.reset();
+            view.addConstraints(*defs);
+            view.setSize(1000, 1000);
+            view.update();
+        }
+        auto readd = ms(start) / 2;
+
+        view.reset();
+        view.addVariant("wide", wideDefs);
+        view.addVariant("narrow", narrowDefs);
+        view.setSize(1000, 1000);
+        view.setVariant("wide");
+        view.update();
+
+        start = Clock::now();
+        view.setVariant("narrow");
+        view.update();
+        auto swapped = ms(start);
+
+        start = Clock::now();
+        view.setVariant("wide");
+        view.update();
+        auto restored = ms(start);
+
+        std::cout << view.subViewCount() << " subviews, switching variant: reset + re-add " << readd << "ms, swap " << swapped << "ms, restore " << restored << "ms" << std::endl;
+    }
+
+    // a page of cards, one title re-measured: hierarchical re-solves that card only
+    void hierarchy()
+    {
+        auto const n = 200;
+        auto defs = "V:|"s;
+        for(int i=0; i<n; i++)
+            defs += "-[c" + std::to_string(i) + "(60):-[t" + std::to_string(i) + ",b" + std::to_string(i) + "]-]";
+        defs += "-(>=8)-|";
+        for(int i=0; i<n; i++)
+            defs += " H:|-[c" + std::to_string(i) + ":-[t" + std::to_string(i) + "]-[b" + std::to_string(i) + "(>=40)]-]-|";
+        auto const parsed = evfl::test::parse(defs);
+
+        auto const m = 1000;
+        double took[2];
+        for(auto hierarchical : { false, true })
+        {
+            autolayout::View view;
+            view.setHierarchical(hierarchical);
+            view.addConstraints(parsed);
+            view.setSize(1000, 20000);
+            view.update();
+
+            auto* title = view.getSubViews().at("t" + std::to_string(n / 2));
+            auto start = Clock::now();
+            for(int i=0; i<m; i++)
+            {
+                title->setIntrinsicWidth(100 + i % 2);
+                view.update();
+            }
+            took[hierarchical] = ms(start) / m;
+        }
+        std::cout << n << " cards, one title re-measured: flat " << took[0] << "ms, hierarchical " << took[1] << "ms" << std::endl;
+    }
+
+    // rows of |-[a(100)]-[b]-[c(50)]-| stacked in one column: only equalities, solved in closed form
+    void closedForm()
+    {
+        auto const n = 500;
+        auto defs = "V:|"s;
+        for(int i=0; i<n; i++)
+            defs += "-[a" + std::to_string(i) + (i < n - 1 ? "(20)]" : "]");
+        defs += "-|";
+        for(int i=0; i<n; i++)
+        {
+            auto const k = std::to_string(i);
+            defs += " H:|-[a" + k + "(100)]-[b" + k + "]-[c" + k + "(50)]-| C:[b" + k + ",c" + k + "].top(a" + k + ").height(a" + k + ")";
+        }
+        auto const parsed = evfl::test::parse(defs);
+
+        auto start = Clock::now();
+        autolayout::View view;
+        view.addConstraints(parsed);
+        view.setSize(1000, 20000);
+        view.update();
+        auto const load = ms(start);
+
+        auto const m = 100;
+        start = Clock::now();
+        for(int i=0; i<m; i++)
+        {
+            view.setSize(1000 + i % 2, 20000 + i % 2);
+            view.update();
+        }
+        std::cout << view.subViewCount() << " subviews in chains (" << view.closedFormConstraints() << " in closed form): load " << load << "ms, resize " << ms(start) / m << "ms" << std::endl;
+    }
+
+    // a 20x20 grid of equal cells: as a G: line, and as the chains and equal sizes it stands for
+    void grid()
+    {
+        auto const n = 20;
+        auto cells = "G:g"s, names = std::string{};
+        for(int r=0; r<n; r++)
+        {
+            cells += "[";
+            for(int c=0; c<n; c++)
+            {
+                auto const name = "r" + std::to_string(r) + "c" + std::to_string(c);
+                cells += (c ? "," : "") + name;
+                names += (r || c ? "," : "") + name;
+            }
+            cells += "]";
+        }
+
+        auto grids = std::vector<ast::GridDef>{};
+        auto const parsed = evfl::test::parse("HV:|-[g]-| " + cells, &grids);
+        auto const chains = evfl::test::parse(evfl::bench::grid(n, n) + "C:[" + names + "].width(r0c0).height(r0c0)");
+
+        auto const m = 100;
+        for(auto native : { false, true })
+        {
+            auto start = Clock::now();
+            autolayout::View view;
+            if(native)
+                view.addGrid(grids[0]);
+            view.addConstraints(native ? parsed : chains);
+            view.setSize(1000, 1000);
+            view.update();
+            auto const load = ms(start);
+
+            start = Clock::now();
+            for(int i=0; i<m; i++)
+            {
+                view.setSize(1000 + i % 2, 1000 + i % 2);
+                view.update();
+            }
+            std::cout << n * n << " cells " << (native ? "as a grid" : "as constraints") << ": load " << load << "ms, resize " << ms(start) / m << "ms" << std::endl;
+        }
+    }
+
+    // a large initial layout in one blocking load, and spread over 4ms steps
+    void stepped()
+    {
+        auto const parsed = evfl::test::parse(grid(1000, 10));
+
+        auto start = Clock::now();
+        {
+            autolayout::View view;
+            view.setSize(1000, 20000);
+            view.addConstraints(parsed);
+            view.update();
+        }
+        auto const blocking = ms(start);
+
+        autolayout::View view;
+        view.setSize(1000, 20000);
+        view.queueConstraints(parsed);
+        auto steps = 0;
+        auto longest = 0.0, total = 0.0;
+        for(auto more = true; more; steps++)
+        {
+            start = Clock::now();
+            more = view.step(4000).value == autolayout::STEP_MORE;
+            longest = std::max(longest, ms(start));
+            total += ms(start);
+        }
+        std::cout << parsed.size() << " constraints: blocking " << blocking << "ms, stepped " << total << "ms in " << steps << " steps of at most " << longest << "ms" << std::endl;
+    }
+
+    // many small views loaded, re-laid out after reset() and destroyed, from the heap and from an arena each
+    void arena()
+    {
+        auto src = std::string{};
+        for(int r=0; r<20; r++)
+        {
+            auto const row = "r" + std::to_string(r);
+            src += "H:|-[" + row + "c0(>=20)]";
+            for(int c=1; c<8; c++)
+                src += "-[" + row + "c" + std::to_string(c) + "(" + row + "c0)]";
+            src += "-(>=8)-| V:|-[" + row + "c0(>=" + std::to_string(10 + r) + ")]-(>=8)-|\n";
+        }
+        auto const defs = evfl::test::parse(src);
+
+        for(auto on : {false, true})
+        {
+            auto const allocations = heapAllocations;
+            auto start = Clock::now();
+            auto stats = autolayout::Arena::Stats{};
+            for(int i=0; i<30; i++)
+            {
+                autolayout::View view;
+                view.setArena(on);
+                for(int round=0; round<3; round++)
+                {
+                    view.reset();
+                    view.addConstraints(defs);
+                    view.setSize(1000, 1000);
+                    view.update();
+                }
+                stats = view.arenaStats();
+            }
+            std::cout << defs.size() << " constraints x 30 views x 3 loads " << (on ? "from an arena" : "from the heap") << ": "
+                << ms(start) << "ms" << allocated(allocations, 30, " per view");
+            if(on)
+                std::cout << ", " << stats.allocations << " from the arena (" << stats.recycled << " recycled) in " << stats.chunks << " chunks";
+            std::cout << std::endl;
+        }
+    }
+
+    // one view re-laid out after reset() with the same names, as a screen changing state does
+    void resetReload()
+    {
+        auto const defs = evfl::test::parse(grid(20, 10));
+        for(auto on : {false, true})
+        {
+            autolayout::View view;
+            view.setArena(on);
+            view.addConstraints(defs);
+            view.setSize(1000, 1000);
+            view.update();
+
+            auto const allocations = heapAllocations;
+            auto start = Clock::now();
+            for(int i=0; i<50; i++)
+            {
+                view.reset();
+                view.addConstraints(defs);
+                view.setSize(1000, 1000);
+                view.update();
+            }
+            std::cout << defs.size() << " constraints, " << view.subViewCount() << " subviews" << (on ? " in an arena" : "") << ": reset and reload "
+                << ms(start) / 50 << "ms" << allocated(allocations, 50) << std::endl;
+        }
+    }
+
+    // constraints toggled on and off for a long time, without compaction, compacted once at the end, and automatically
+    void compaction()
+    {
+        auto src = std::string{}, toggles = std::string{};
+        for(int r=0; r<20; r++)
+        {
+            auto const row = "r" + std::to_string(r);
+            src += "H:|-[" + row + "c0(>=20)]";
+            for(int c=1; c<8; c++)
+                src += "-[" + row + "c" + std::to_string(c) + "(" + row + "c0)]";
+            src += "-(>=8)-| V:|-[" + row + "c0(>=" + std::to_string(10 + r) + ")]-(>=8)-|\n";
+            toggles += "H:[" + row + "c0(>=" + std::to_string(60 + r) + "@500)]\n";
+        }
+        auto const defs = evfl::test::parse(src), toggled = evfl::test::parse(toggles);
+
+        for(auto factor : {0.0, 4.0})
+        {
+            autolayout::View view;
+            view.setAutoCompact(factor);
+            view.addConstraints(defs);
+            view.setSize(1000, 1000);
+            view.update();
+            auto const loaded = view.memoryBytes();
+
+            auto start = Clock::now();
+            for(int i=0; i<2000; i++)
+            {
+                std::vector<autolayout::ViewConstraint> collected;
+                view.addConstraints(toggled, &collected);
+                view.update();
+                for(auto& c : collected)
+                    view.removeConstraint(c);
+                view.update();
+            }
+            auto const churn = ms(start) / 2000;
+            auto const churned = view.memoryBytes();
+
+            std::cout << defs.size() << " constraints, " << toggled.size() << " toggled 2000 times" << (factor ? ", auto-compacted: " : ": ")
+                << churn << "ms per toggle, " << loaded / 1024 << "KB -> " << churned / 1024 << "KB";
+            if(factor)
+                std::cout << " (" << view.autoCompacted() / 1024 << "KB reclaimed on the way)";
+            else
+            {
+                start = Clock::now();
+                auto const reclaimed = view.compact();
+                std::cout << ", compact() " << ms(start) << "ms reclaims " << reclaimed / 1024 << "KB";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    // loading, where every attribute a constraint names gets a variable, and reading every subview's frame back
+    void variables()
+    {
+        for(auto rows : {50, 500})
+        {
+            auto const defs = evfl::test::parse(grid(rows, 10));
+            auto const allocations = heapAllocations;
+            auto start = Clock::now();
+            autolayout::View view;
+            view.addConstraints(defs);
+            view.setSize(1000, 1000);
+            view.update();
+            auto const load = ms(start);
+            auto const loaded = allocated(allocations, 1);
+
+            start = Clock::now();
+            auto sum = 0.0;
+            for(int i=0; i<100; i++)
+                sum += view.frames()[i % 4];
+            auto const frames = ms(start) / 100;
+
+            start = Clock::now();
+            for(int i=0; i<100; i++)
+            {
+                auto const* values = view.variables().values();
+                for(size_t v=0; v<view.variables().size(); v++)
+                    sum += values[v];
+            }
+            std::cout << defs.size() << " constraints, " << view.variables().size() << " variables: load " << load << "ms"
+                << loaded << "; frames() " << frames << "ms, every value " << ms(start) / 100
+                << "ms" << (sum == 0 ? " " : "") << std::endl;
+        }
+    }
+
+    void all()
+    {
+        bulkLoad();
+        batchedSuggest();
+        smallUpdate();
+        solveRows();
+        variants();
+        hierarchy();
+        closedForm();
+        grid();
+        stepped();
+        arena();
+        resetReload();
+        compaction();
+        variables();
+    }
+}
+
+int main(int argc, char** argv)
 {
     namespace x3 = boost::spirit::x3;
     namespace ascii = x3::ascii;
     namespace al = autolayout;
     namespace ast = evfl::ast;
 
+    if(argc > 1 && argv[1] == "bench"s)
+    {
+        evfl::bench::all();
+        return 0;
+    }
+
     evfl::test::all();
 
 //	{
@@ -7,6 +7,7 @@
 #include "ast.hpp"
 #include "syntax.hpp"
 #include "../autolayout/constraint_def.h"
+#include "../autolayout/grid_def.h"
 
 namespace evfl::visit
 {
@@ -303,6 +304,7 @@ namespace evfl::visit
 
 		auto const& [superTo, rest, toSuper] = cascade;
 		auto* prevGroup = &cascade.first();
+		auto const begin = output.size();
 
 		visitConnection(superTo, orient, superGroup, *prevGroup, ConnectionType::FROMSUPER, super.name, firstTildeName, output);
 		visitGroup(*prevGroup, orient, super.name, output);
@@ -316,6 +318,12 @@ namespace evfl::visit
 		}
 
 		visitConnection(toSuper, orient, *prevGroup, superGroup, ConnectionType::TOSUPER, super.name, firstTildeName, output);
+
+		// nested cascades claimed theirs already
+		if(!autolayout::is_super(super.name))
+			for(auto i=begin; i<output.size(); i++)
+				if(output[i].container.empty())
+					output[i].container = super.name;
 	}
 
 //	inline void visitEvfl(
@@ -355,12 +363,24 @@ namespace evfl::visit
 //		}
 //	}
 
+	// grids: where G: lines go; without one they are skipped
 	inline void visitMultiEvfl(
 			const ast::MultiExtendedVisualFormat& ast,
-			std::vector<ast::ConstraintDef>& output)
+			std::vector<ast::ConstraintDef>& output,
+			std::vector<ast::GridDef>* grids = nullptr)
 	{
 		for(auto const& line : ast)
 		{
+			if(auto const* gridFormatRow = boost::get<ast::MultiGridFormatRow>(&line))
+			{
+				for(auto const& grid : *gridFormatRow)
+				{
+					if(grids)
+						grids->push_back(ast::GridDef{ grid.name, grid.columns.value_or(std::vector<ast::Track>{}), grid.rows.value_or(std::vector<ast::Track>{}), grid.cells });
+				}
+				continue;
+			}
+
 			if(auto const* visualFormatRow = boost::get<ast::MultiVisualFormatRow>(&line))
 			{
 				auto const orient = visualFormatRow->orientation;
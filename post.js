@@ -19,4 +19,30 @@ Module['ready'] = new Promise(function(resolve, reject) {
         }
     }
 
-});
\ No newline at end of file
+});
+
+// Resolves once view.step() has added and solved everything queued with raw_queueConstraints, stepping for
+// budgetMicros (default 4000) per animation frame so a large layout doesn't block the page meanwhile.
+// Rejects with the status name if a step fails (step() returns it negated).
+Module['stepAsync'] = function(view, budgetMicros) {
+    budgetMicros = budgetMicros === undefined ? 4000 : budgetMicros;
+    var next = typeof requestAnimationFrame === 'function' ? requestAnimationFrame : function(fn) { setTimeout(fn, 0); };
+
+    return new Promise(function(resolve, reject) {
+        function frame() {
+            try {
+                var result = view['step'](budgetMicros);
+                if(result < 0)
+                    reject(Error(Module['statusName'](-result)));
+                else if(result === Module['StepResult']['DONE'].value)
+                    resolve(view);
+                else
+                    next(frame);
+            }
+            catch(e) {
+                reject(e);
+            }
+        }
+        frame();
+    });
+};